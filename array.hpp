@@ -1,16 +1,234 @@
 ﻿#pragma once
 
+#include <functional>
+#include <memory>
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#include <memory_resource>
+#define MATSULIB_ARRAY_PMR 1
+#endif
+#endif
+
 namespace matsulib
 {
-  template <class _T> class Array;
+  template <class _T, class _Allocator = std::allocator <_T>> class Array;
+
+#if defined(MATSULIB_ARRAY_PMR)
+  namespace pmr
+  {
+    // Array drawing from a std::pmr::memory_resource (e.g. monotonic_buffer_resource).
+    // map / select / inject results are allocated from the same resource.
+    template <class _T> using Array = matsulib::Array <_T, std::pmr::polymorphic_allocator <_T>>;
+  }
+#endif
+  template <class _T, class _Source> class LazyArray;
+  template <class _Key, class _Value, class _Hash = std::hash <_Key>, class _KeyEqual = std::equal_to <_Key>> class FlatHashMap;
+
+  namespace _detail
+  {
+    namespace lazy
+    {
+      template <class _T, class _Allocator> struct ArraySource;
+    }
+    namespace flat_hash_map
+    {
+      inline auto mix(std::size_t hash) -> std::size_t;
+    }
+  }
 }
 
+#include "execution.hpp"
+#include "simd.hpp"
+#include "details/sort.hpp"
+#include <atomic>
 #include <vector>
-#include <functional>
+#include <type_traits>
+#include <stdexcept>
+#include <utility>
+#include <algorithm>
+#include <string>
+
+namespace matsulib
+{
+  namespace _detail
+  {
+    namespace array
+    {
+      // Keeps explicitly specified _DistType from being deduced by initial_value.
+      template <class _T> struct Identity { using type = _T; };
+
+      // Leaves std::function arguments to the std::function overloads.
+      template <class _T> struct IsFunction : public std::false_type {};
+      template <class _Signature> struct IsFunction <std::function <_Signature>> : public std::true_type {};
+      template <class _Func, class _Result>
+      using DisableIfFunction = typename std::enable_if <!IsFunction <typename std::decay <_Func>::type>::value, _Result>::type;
+      // Leaves execution::ParallelPolicy arguments (rvalues and non-const lvalues too) to the policy overloads.
+      template <class _Func, class _Result>
+      using DisableIfPolicy = typename std::enable_if <!std::is_same <typename std::decay <_Func>::type, matsulib::execution::ParallelPolicy>::value, _Result>::type;
+
+      // Hash grouping steps (Array::hash_group) : add value (index-th element) to the group of key, true if the group is new.
+      template <class _Allocator>
+      struct GroupEmplace
+      {
+      public:
+        _Allocator allocator;
+        template <class _Map, class _Key, class _T>
+        auto operator ()(_Map &groups, _Key &&key, const _T &value, std::size_t) const -> bool
+        {
+          const auto found = groups.try_emplace(std::forward <_Key>(key), 1, value, allocator);
+          if (!found.second)
+          {
+            found.first->second.push_back(value);
+          }
+          return found.second;
+        }
+      };
+      struct CountEmplace
+      {
+      public:
+        template <class _Map, class _Key, class _T>
+        auto operator ()(_Map &groups, _Key &&key, const _T &, std::size_t) const -> bool
+        {
+          const auto found = groups.try_emplace(std::forward <_Key>(key), 0);
+          ++found.first->second;
+          return found.second;
+        }
+      };
+      struct LastEmplace
+      {
+      public:
+        template <class _Map, class _Key, class _T>
+        auto operator ()(_Map &groups, _Key &&key, const _T &value, std::size_t) const -> bool
+        {
+          const auto found = groups.try_emplace(std::forward <_Key>(key), value);
+          if (!found.second)
+          {
+            found.first->second = value;
+          }
+          return found.second;
+        }
+      };
+      struct FirstIndexEmplace
+      {
+      public:
+        template <class _Map, class _Key, class _T>
+        auto operator ()(_Map &groups, _Key &&key, const _T &, std::size_t index) const -> bool
+        {
+          return groups.try_emplace(std::forward <_Key>(key), index).second;
+        }
+      };
+      // running sum with Neumaier compensation
+      template <class _T>
+      struct CompensatedSum
+      {
+      public:
+        _T sum;
+        _T compensation;
+
+        auto add(_T value) -> void
+        {
+          const auto total = sum + value;
+          compensation += (sum < 0 ? -sum : sum) >= (value < 0 ? -value : value) ? (sum - total) + value : (value - total) + sum;
+          sum = total;
+        }
+        auto join(const CompensatedSum &other) const -> CompensatedSum
+        {
+          auto joined = CompensatedSum{ sum, compensation + other.compensation };
+          joined.add(other.sum);
+          return joined;
+        }
+      };
+      struct Self
+      {
+      public:
+        template <class _T>
+        auto operator ()(const _T &value) const -> const _T & { return value; }
+      };
+
+      // dst_array = { func(0), ..., func(length - 1) } computed in num_of_chunks chunks of the shared Scheduler.
+      // Default constructible results are assigned into the resized array; the others are built per chunk
+      // and moved into dst_array in order, so they only need to be move constructible.
+      template <class _Array, class _Func>
+      inline auto parallel_map(std::size_t num_of_chunks, std::size_t length, _Array &dst_array, _Func &func, std::true_type) -> void
+      {
+        dst_array.resize(length);
+        const auto dst_data = dst_array.data();
+        matsulib::_detail::execution::run_chunks(num_of_chunks, length, [&](std::size_t, std::size_t begin, std::size_t end)
+        {
+          for (auto i = begin; i < end; ++i)
+          {
+            dst_data[i] = func(i);
+          }
+        });
+      }
+      template <class _Array, class _Func>
+      inline auto parallel_map(std::size_t num_of_chunks, std::size_t length, _Array &dst_array, _Func &func, std::false_type) -> void
+      {
+        dst_array.reserve(length);
+        if (num_of_chunks <= 1)
+        {
+          for (std::size_t i = 0; i < length; ++i)
+          {
+            dst_array.emplace_back(func(i));
+          }
+          return;
+        }
+        auto chunks = std::vector <_Array>{};
+        chunks.reserve(num_of_chunks);
+        for (std::size_t chunk = 0; chunk < num_of_chunks; ++chunk)
+        {
+          chunks.emplace_back(dst_array.get_allocator());
+        }
+        matsulib::_detail::execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, std::size_t begin, std::size_t end)
+        {
+          chunks[chunk].reserve(end - begin);
+          for (auto i = begin; i < end; ++i)
+          {
+            chunks[chunk].emplace_back(func(i));
+          }
+        });
+        for (auto &chunk : chunks)
+        {
+          for (auto &value : chunk)
+          {
+            dst_array.emplace_back(std::move(value));
+          }
+        }
+      }
+      template <class _Array, class _Func>
+      inline auto parallel_map(std::size_t num_of_chunks, std::size_t length, _Array &dst_array, _Func &&func) -> void
+      {
+        parallel_map(num_of_chunks, length, dst_array, func, std::is_default_constructible <typename _Array::value_type>{});
+      }
+    }
+  }
+}
+
+namespace matsulib
+{
+  // True when moving an object to another address and forgetting the source is the same as copying its bytes
+  // (SmallArray relocates such elements with memcpy). Specialize it for types that qualify without being trivially copyable.
+  template <class _T>
+  struct IsTriviallyRelocatable : public std::integral_constant <bool, std::is_trivially_copyable <_T>::value> {};
+
+  // Array holds no pointer to itself (no vtable, std::vector is three pointers plus the allocator),
+  // except for the checked iterators of debugging standard libraries.
+#if !defined(_GLIBCXX_DEBUG) && !(defined(_ITERATOR_DEBUG_LEVEL) && _ITERATOR_DEBUG_LEVEL != 0)
+  template <class _T, class _Allocator>
+  struct IsTriviallyRelocatable <Array <_T, _Allocator>> : public IsTriviallyRelocatable <_Allocator> {};
+  template <class _T>
+  struct IsTriviallyRelocatable <std::allocator <_T>> : public std::true_type {};
+#if defined(MATSULIB_ARRAY_PMR)
+  template <class _T>
+  struct IsTriviallyRelocatable <std::pmr::polymorphic_allocator <_T>> : public std::true_type {};
+#endif
+#endif
+}
 
-template <class _T>
+template <class _T, class _Allocator>
 class matsulib::Array
-  : public std::vector <_T>
+  : public std::vector <_T, _Allocator>
 {
 public:
   Array() = default;
@@ -18,28 +236,41 @@ public:
   Array(Array &&) = default;
   Array &operator =(const Array &) = default;
   Array &operator =(Array &&) = default;
-  virtual ~Array() = default;
 
-  using parent = std::vector <_T>;
+  using parent = std::vector <_T, _Allocator>;
   using parent::parent;
+  using typename parent::size_type;
+  using typename parent::const_iterator;
+
+  // find_index result when nothing matches
+  static constexpr size_type npos = static_cast <size_type>(-1);
+  // block length of reduce / sum (policy) / compensated_sum, fixed so that results do not depend on the threads
+  static constexpr size_type REDUCE_BLOCK = 2048;
 
-  auto each_with_index(std::function <void(const _T &value, size_type index)> func) const -> const Array <_T> &;
-  auto each_with_index(std::function <void(const _T &value, size_type index)> func) -> Array <_T> &;
-  auto each(std::function <void(const _T &value)> func) const -> const Array <_T> &;
-  auto each(std::function <void(const _T &value)> func) -> Array <_T> &;
+  // Array of another element type sharing this allocator (map / inject results).
+  template <class _DistType>
+  using array_of = Array <_DistType, typename std::allocator_traits <_Allocator>::template rebind_alloc <_DistType>>;
+  // decayed result of key_of(element) (group_by / index_by keys)
+  template <class _Func>
+  using key_of_t = typename std::decay <decltype(std::declval <_Func &>()(std::declval <const _T &>()))>::type;
+
+  auto each_with_index(std::function <void(const _T &value, size_type index)> func) const -> const Array <_T, _Allocator> &;
+  auto each_with_index(std::function <void(const _T &value, size_type index)> func) -> Array <_T, _Allocator> &;
+  auto each(std::function <void(const _T &value)> func) const -> const Array <_T, _Allocator> &;
+  auto each(std::function <void(const _T &value)> func) -> Array <_T, _Allocator> &;
 
-  auto transform_with_index(std::function <_T(_T value, size_type index)> func) -> Array <_T> &;
-  auto transform(std::function <_T(_T value)> func)->Array <_T> &;
+  auto transform_with_index(std::function <_T(_T value, size_type index)> func) -> Array <_T, _Allocator> &;
+  auto transform(std::function <_T(_T value)> func)->Array <_T, _Allocator> &;
 
-  auto select_with_index(std::function <bool(const _T &value, size_type index)> func) const -> Array <_T>;
-  auto select(std::function <bool(const _T &value)> func) const -> Array <_T>;
+  auto select_with_index(std::function <bool(const _T &value, size_type index)> func) const -> Array <_T, _Allocator>;
+  auto select(std::function <bool(const _T &value)> func) const -> Array <_T, _Allocator>;
 
   template <class _DistType>
-  auto map_with_index(std::function <_DistType(const _T &value, size_type index)> func) const -> Array <_DistType>;
-  auto map_with_index(std::function <_T(const _T &value, size_type index)> func) const -> Array <_T>;
+  auto map_with_index(std::function <_DistType(const _T &value, size_type index)> func) const -> array_of <_DistType>;
+  auto map_with_index(std::function <_T(const _T &value, size_type index)> func) const -> Array <_T, _Allocator>;
   template <class _DistType>
-  auto map(std::function <_DistType(const _T &value)> func) const -> Array <_DistType>;
-  auto map(std::function <_T(const _T &value)> func) const -> Array <_T>;
+  auto map(std::function <_DistType(const _T &value)> func) const -> array_of <_DistType>;
+  auto map(std::function <_T(const _T &value)> func) const -> Array <_T, _Allocator>;
 
   template <class _DistType>
   auto inject_with_index(_DistType initial_value, std::function <_DistType(_DistType accumulation, const _T &value, size_type index)> func) const -> _DistType;
@@ -50,168 +281,1726 @@ public:
   template <class _DistType>
   auto inject(std::function <_DistType(_DistType accumulation, const _T &value)> func) const -> _DistType;
   auto inject(std::function <_T(_T accumulation, const _T &value)> func) const -> _T;
+
+  // Generic callable overloads : lambdas are called directly (no std::function) so they can be inlined.
+  template <class _Func>
+  auto each_with_index(_Func &&func) const -> const Array <_T, _Allocator> &;
+  template <class _Func>
+  auto each_with_index(_Func &&func) -> Array <_T, _Allocator> &;
+  template <class _Func>
+  auto each(_Func &&func) const -> const Array <_T, _Allocator> &;
+  template <class _Func>
+  auto each(_Func &&func) -> Array <_T, _Allocator> &;
+
+  template <class _Func>
+  auto transform_with_index(_Func &&func) -> Array <_T, _Allocator> &;
+  template <class _Func>
+  auto transform(_Func &&func) -> Array <_T, _Allocator> &;
+
+  template <class _Func>
+  auto select_with_index(_Func &&func) const -> Array <_T, _Allocator>;
+  template <class _Func>
+  auto select(_Func &&func) const -> Array <_T, _Allocator>;
+
+  template <class _DistType, class _Func>
+  auto map_with_index(_Func &&func) const & -> array_of <_DistType>;
+  template <class _Func>
+  auto map_with_index(_Func &&func) const & -> Array <_T, _Allocator>;
+  template <class _DistType, class _Func>
+  auto map(_Func &&func) const & -> array_of <_DistType>;
+  template <class _Func>
+  auto map(_Func &&func) const & -> Array <_T, _Allocator>;
+  // Consuming overloads : mapping an rvalue Array to its own element type overwrites its buffer in place.
+  template <class _DistType, class _Func>
+  auto map_with_index(_Func &&func) && -> _detail::array::DisableIfFunction <_Func, array_of <_DistType>>;
+  template <class _Func>
+  auto map_with_index(_Func &&func) && -> _detail::array::DisableIfFunction <_Func, Array <_T, _Allocator>>;
+  template <class _DistType, class _Func>
+  auto map(_Func &&func) && -> _detail::array::DisableIfFunction <_Func, array_of <_DistType>>;
+  template <class _Func>
+  auto map(_Func &&func) && -> _detail::array::DisableIfFunction <_Func, Array <_T, _Allocator>>;
+
+  template <class _DistType, class _Func>
+  auto inject_with_index(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _detail::array::DisableIfFunction <_Func, _DistType>;
+  template <class _Func>
+  auto inject_with_index(_T initial_value, _Func &&func) const -> _T;
+  template <class _DistType, class _Func>
+  auto inject(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _detail::array::DisableIfFunction <_Func, _DistType>;
+  template <class _Func>
+  auto inject(_T initial_value, _Func &&func) const -> _T;
+  template <class _DistType, class _Func>
+  auto inject(_Func &&func) const -> _DistType;
+  template <class _Func>
+  auto inject(_Func &&func) const -> _T;
+
+  // Parallel overloads : split [0, size()) into contiguous chunks processed on separate threads.
+  template <class _Func>
+  auto transform_with_index(const execution::ParallelPolicy &policy, _Func &&func) -> Array <_T, _Allocator> &;
+  template <class _Func>
+  auto transform(const execution::ParallelPolicy &policy, _Func &&func) -> Array <_T, _Allocator> &;
+
+  template <class _Func>
+  auto select_with_index(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>;
+  template <class _Func>
+  auto select(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>;
+
+  template <class _DistType, class _Func>
+  auto map_with_index(const execution::ParallelPolicy &policy, _Func &&func) const -> array_of <_DistType>;
+  template <class _Func>
+  auto map_with_index(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>;
+  template <class _DistType, class _Func>
+  auto map(const execution::ParallelPolicy &policy, _Func &&func) const -> array_of <_DistType>;
+  template <class _Func>
+  auto map(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>;
+
+  // initial_value seeds every chunk, so it must be an identity of combine (e.g. 0 for +).
+  // Chunk results are merged by a pairwise tree of combine(left, right) calls.
+  template <class _DistType, class _Func, class _Combine>
+  auto inject_with_index(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> _DistType;
+  template <class _Func, class _Combine>
+  auto inject_with_index(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> _T;
+  template <class _DistType, class _Func, class _Combine>
+  auto inject(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> _DistType;
+  template <class _Func, class _Combine>
+  auto inject(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> _T;
+
+  // Deterministic reduction by an associative func(lhs, rhs) with identity : fixed blocks reduced from identity,
+  // then a fixed pairwise tree over the blocks. reduce and reduce (par, ...) return bitwise the same result.
+  template <class _Func>
+  auto reduce(_T identity, _Func &&func) const -> _T;
+  template <class _Func>
+  auto reduce(const execution::ParallelPolicy &policy, _T identity, _Func &&func) const -> _T;
+
+  // Running accumulations (same length as this) :
+  //   scan           -> [f(init, a0), f(f(init, a0), a1), ...]
+  //   exclusive_scan -> [init, f(init, a0), ...]
+  template <class _DistType, class _Func>
+  auto scan_with_index(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> array_of <_DistType>;
+  template <class _Func>
+  auto scan_with_index(_T initial_value, _Func &&func) const -> Array <_T, _Allocator>;
+  template <class _DistType, class _Func>
+  auto scan(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> array_of <_DistType>;
+  template <class _Func>
+  auto scan(_T initial_value, _Func &&func) const -> Array <_T, _Allocator>;
+  template <class _DistType, class _Func>
+  auto exclusive_scan_with_index(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> array_of <_DistType>;
+  template <class _Func>
+  auto exclusive_scan_with_index(_T initial_value, _Func &&func) const -> Array <_T, _Allocator>;
+  template <class _DistType, class _Func>
+  auto exclusive_scan(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> array_of <_DistType>;
+  template <class _Func>
+  auto exclusive_scan(_T initial_value, _Func &&func) const -> Array <_T, _Allocator>;
+
+  // Parallel scans (two passes) : chunk totals are reduced from initial_value (an identity of combine as in parallel inject),
+  // prefixed by combine, then every chunk is rescanned from its prefix.
+  template <class _DistType, class _Func, class _Combine>
+  auto scan_with_index(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> array_of <_DistType>;
+  template <class _Func, class _Combine>
+  auto scan_with_index(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> Array <_T, _Allocator>;
+  template <class _DistType, class _Func, class _Combine>
+  auto scan(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> array_of <_DistType>;
+  template <class _Func, class _Combine>
+  auto scan(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> Array <_T, _Allocator>;
+  template <class _DistType, class _Func, class _Combine>
+  auto exclusive_scan_with_index(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> array_of <_DistType>;
+  template <class _Func, class _Combine>
+  auto exclusive_scan_with_index(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> Array <_T, _Allocator>;
+  template <class _DistType, class _Func, class _Combine>
+  auto exclusive_scan(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> array_of <_DistType>;
+  template <class _Func, class _Combine>
+  auto exclusive_scan(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> Array <_T, _Allocator>;
+
+  // Short-circuiting queries : the scan stops at the first element that decides the answer.
+  // The par overloads stop the remaining chunks once it is known; find / find_index still report the lowest matching index.
+  template <class _Func>
+  auto any(_Func &&func) const -> bool;
+  template <class _Func>
+  auto any(const execution::ParallelPolicy &policy, _Func &&func) const -> bool;
+  template <class _Func>
+  auto all(_Func &&func) const -> bool;
+  template <class _Func>
+  auto all(const execution::ParallelPolicy &policy, _Func &&func) const -> bool;
+  template <class _Func>
+  auto none(_Func &&func) const -> bool;
+  template <class _Func>
+  auto none(const execution::ParallelPolicy &policy, _Func &&func) const -> bool;
+  template <class _Func>
+  auto find_index(_Func &&func) const -> size_type;
+  template <class _Func>
+  auto find_index(const execution::ParallelPolicy &policy, _Func &&func) const -> size_type;
+  template <class _Func>
+  auto find(_Func &&func) const -> const_iterator;
+  template <class _Func>
+  auto find(const execution::ParallelPolicy &policy, _Func &&func) const -> const_iterator;
+  // leading elements satisfying func / everything after them
+  template <class _Func>
+  auto take_while(_Func &&func) const -> Array <_T, _Allocator>;
+  template <class _Func>
+  auto take_while(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>;
+  template <class _Func>
+  auto drop_while(_Func &&func) const -> Array <_T, _Allocator>;
+  template <class _Func>
+  auto drop_while(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>;
+
+  // Deferred select / map chain evaluated in a single pass (see lazy_array.hpp).
+  auto lazy() const -> LazyArray <_T, _detail::lazy::ArraySource <_T, _Allocator>>;
+
+  // Numeric kernels (see simd.hpp) : SSE2 / AVX2 for float, int32_t and uint8_t, plain loops otherwise.
+  // NaN : min / max / minmax skip NaN elements (NaN only when every element is NaN) and clamp turns NaN into low,
+  // the same with or without a vector unit and wherever the data is aligned.
+  // Deterministic sums : fixed blocks of REDUCE_BLOCK elements (SIMD kernel per block) joined by a fixed pairwise tree,
+  // so the result is bitwise the same with or without par and whatever the number of threads.
+  // compensated_sum adds Neumaier compensation inside the blocks and across the tree.
+  auto sum() const -> typename simd::SumType <_T>::type;
+  auto sum(const execution::ParallelPolicy &policy) const -> typename simd::SumType <_T>::type;
+  auto compensated_sum() const -> typename simd::SumType <_T>::type;
+  auto compensated_sum(const execution::ParallelPolicy &policy) const -> typename simd::SumType <_T>::type;
+  auto dot(const Array <_T, _Allocator> &other) const -> typename simd::SumType <_T>::type;
+  auto min() const -> _T;
+  auto max() const -> _T;
+  auto minmax() const -> std::pair <_T, _T>;
+  auto count_if(simd::Compare compare, const _T &value) const -> size_type;
+  auto add(const Array <_T, _Allocator> &other) -> Array <_T, _Allocator> &;
+  auto mul(const Array <_T, _Allocator> &other) -> Array <_T, _Allocator> &;
+  auto scale(const _T &factor) -> Array <_T, _Allocator> &;
+  auto clamp(const _T &low, const _T &high) -> Array <_T, _Allocator> &;
+
+  // In-place filters : survivors are moved forward inside the existing buffer (order is kept).
+  // shrink = true releases the unused capacity afterwards.
+  template <class _Func>
+  auto keep_if_with_index(_Func &&func, bool shrink = false) -> Array <_T, _Allocator> &;
+  template <class _Func>
+  auto keep_if(_Func &&func, bool shrink = false) -> Array <_T, _Allocator> &;
+  template <class _Func>
+  auto delete_if_with_index(_Func &&func, bool shrink = false) -> Array <_T, _Allocator> &;
+  template <class _Func>
+  auto delete_if(_Func &&func, bool shrink = false) -> Array <_T, _Allocator> &;
+
+  // Reorders elements so that those satisfying func come first and returns the size of that group.
+  template <class _Func>
+  auto partition(_Func &&func) -> size_type;
+  template <class _Func>
+  auto stable_partition(_Func &&func) -> size_type;
+
+  // In-place ascending sorts. Integer / floating point elements (and keys of sort_by) are LSD radix sorted,
+  // anything else is sorted per chunk and merged (with par, chunks and merges run in parallel).
+  // sort_by / stable_sort_by call key_of once per element and order by the cached keys.
+  auto sort() -> Array <_T, _Allocator> &;
+  auto sort(const execution::ParallelPolicy &policy) -> Array <_T, _Allocator> &;
+  template <class _Compare>
+  auto sort(_Compare &&compare) -> _detail::array::DisableIfPolicy <_Compare, Array <_T, _Allocator> &>;
+  template <class _Compare>
+  auto sort(const execution::ParallelPolicy &policy, _Compare &&compare) -> _detail::array::DisableIfPolicy <_Compare, Array <_T, _Allocator> &>;
+  template <class _Func>
+  auto sort_by(_Func &&key_of) -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator> &>;
+  template <class _Func>
+  auto sort_by(const execution::ParallelPolicy &policy, _Func &&key_of) -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator> &>;
+  template <class _Func>
+  auto stable_sort_by(_Func &&key_of) -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator> &>;
+  template <class _Func>
+  auto stable_sort_by(const execution::ParallelPolicy &policy, _Func &&key_of) -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator> &>;
+
+  // Hash grouping into FlatHashMap (see flat_hash_map.hpp); groups, counts and survivors keep the order of first appearance.
+  //   group_by : key -> elements, tally : element -> count, index_by : key -> last element, uniq : first element per key
+  // The par overloads partition the keys by hash and build every partition on its own thread (key_of is called twice per element).
+  template <class _Func>
+  auto group_by(_Func &&key_of) const -> FlatHashMap <key_of_t <_Func>, Array <_T, _Allocator>>;
+  template <class _Func>
+  auto group_by(const execution::ParallelPolicy &policy, _Func &&key_of) const -> FlatHashMap <key_of_t <_Func>, Array <_T, _Allocator>>;
+  auto tally() const -> FlatHashMap <_T, size_type>;
+  auto tally(const execution::ParallelPolicy &policy) const -> FlatHashMap <_T, size_type>;
+  template <class _Func>
+  auto index_by(_Func &&key_of) const -> FlatHashMap <key_of_t <_Func>, _T>;
+  template <class _Func>
+  auto index_by(const execution::ParallelPolicy &policy, _Func &&key_of) const -> FlatHashMap <key_of_t <_Func>, _T>;
+  auto uniq() const -> Array <_T, _Allocator>;
+  auto uniq(const execution::ParallelPolicy &policy) const -> Array <_T, _Allocator>;
+  template <class _Func>
+  auto uniq(_Func &&key_of) const -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator>>;
+  template <class _Func>
+  auto uniq(const execution::ParallelPolicy &policy, _Func &&key_of) const -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator>>;
+
+  // Writes a header and the raw elements in one write; the file can be opened as MappedArray <_T>.
+  // Defined in mapped_array.hpp (kept out of array.hpp for its platform headers) : callers must include mapped_array.hpp.
+  auto save_binary(const std::string &filename) const -> void;
+
+protected:
+  template <class _DistType, class _Func>
+  auto map_with_index_consuming(_Func &&func, std::true_type) -> array_of <_DistType>;
+  template <class _DistType, class _Func>
+  auto map_with_index_consuming(_Func &&func, std::false_type) -> array_of <_DistType>;
+  template <class _DistType, class _Func>
+  auto scan_impl(_DistType initial_value, _Func &func, bool exclusive) const -> array_of <_DistType>;
+  template <class _DistType, class _Func, class _Combine>
+  auto scan_impl(const execution::ParallelPolicy &policy, _DistType initial_value, _Func &func, _Combine &combine, bool exclusive) const -> array_of <_DistType>;
+  // emplace(map, key, value, index) -> inserted, for every element in order (per partition with num_of_chunks > 1)
+  template <class _Key, class _Value, class _Func, class _Emplace>
+  auto hash_group(std::size_t num_of_chunks, _Func &key_of, _Emplace emplace) const -> FlatHashMap <_Key, _Value>;
+  template <class _Func>
+  auto uniq_impl(std::size_t num_of_chunks, _Func &key_of) const -> Array <_T, _Allocator>;
+  // block_func(begin, end) for every block of REDUCE_BLOCK elements, joined by combine in a fixed pairwise tree
+  template <class _DistType, class _Block, class _Combine>
+  auto blocked_reduce(std::size_t num_of_chunks, _DistType identity, _Block &&block_func, _Combine &&combine) const -> _DistType;
+  auto sum_impl(std::size_t num_of_chunks) const -> typename simd::SumType <_T>::type;
+  auto compensated_sum_impl(std::size_t num_of_chunks) const -> typename simd::SumType <_T>::type;
+  template <class _Func>
+  auto reduce_impl(std::size_t num_of_chunks, _T identity, _Func &func) const -> _T;
+  // lowest index whose element satisfies func (npos if none) ; with lowest == false any matching index, all chunks stopping at the first match
+  template <class _Func>
+  auto find_index_impl(std::size_t num_of_chunks, _Func &func, bool lowest) const -> size_type;
 };
 
-template <class _T>
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::each_with_index(std::function <void(const _T &value, size_type index)> func) const -> const Array <_T, _Allocator> &
+{
+  return each_with_index([&func](const _T &value, size_type index) { func(value, index); });
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::each_with_index(std::function <void(const _T &value, size_type index)> func) -> Array <_T, _Allocator> &
+{
+  return each_with_index([&func](const _T &value, size_type index) { func(value, index); });
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::each(std::function <void(const _T &value)> func) const -> const Array <_T, _Allocator> &
+{
+  return each_with_index([&func](const _T &value, size_type) { func(value); });
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::each(std::function <void(const _T &value)> func) -> Array <_T, _Allocator> &
+{
+  return each_with_index([&func](const _T &value, size_type) { func(value); });
+}
+
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::transform_with_index(std::function <_T(_T value, size_type index)> func) -> Array <_T, _Allocator> &
+{
+  return transform_with_index([&func](_T value, size_type index) { return func(std::move(value), index); });
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::transform(std::function <_T(_T value)> func) -> Array <_T, _Allocator> &
+{
+  return transform_with_index([&func](_T value, size_type) { return func(std::move(value)); });
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::select_with_index(std::function <bool(const _T &value, size_type index)> func) const -> Array <_T, _Allocator>
+{
+  return select_with_index([&func](const _T &value, size_type index) { return func(value, index); });
+}
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::select(std::function <bool(const _T &value)> func) const -> Array <_T, _Allocator>
+{
+  return select_with_index([&func](const _T &value, size_type) { return func(value); });
+}
+
+template <class _T, class _Allocator>
+template <class _DistType>
+inline
+auto matsulib::Array <_T, _Allocator>::map_with_index(std::function <_DistType(const _T &value, size_type index)> func) const -> array_of <_DistType>
+{
+  return map_with_index <_DistType>([&func](const _T &value, size_type index) { return func(value, index); });
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::map_with_index(std::function <_T(const _T &value, size_type index)> func) const -> Array <_T, _Allocator>
+{
+  return map_with_index <_T>(func);
+}
+
+template <class _T, class _Allocator>
+template <class _DistType>
+inline
+auto matsulib::Array <_T, _Allocator>::map(std::function <_DistType(const _T &value)> func) const -> array_of <_DistType>
+{
+  return map_with_index <_DistType>([&func](const _T &value, size_type) { return func(value); });
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::map(std::function <_T(const _T &value)> func) const -> Array <_T, _Allocator>
+{
+  return map_with_index <_T>([&func](const _T &value, size_type) { return func(value); });
+}
+
+template <class _T, class _Allocator>
+template <class _DistType>
+inline
+auto matsulib::Array <_T, _Allocator>::inject_with_index(_DistType initial_value, std::function <_DistType(_DistType accumulation, const _T &value, size_type index)> func) const -> _DistType
+{
+  return inject_with_index <_DistType>(std::move(initial_value), [&func](_DistType accumulation, const _T &value, size_type index) { return func(std::move(accumulation), value, index); });
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::inject_with_index(_T initial_value, std::function <_T(_T accumulation, const _T &value, size_type index)> func) const -> _T
+{
+  return inject_with_index <_T>(std::move(initial_value), func);
+}
+
+template <class _T, class _Allocator>
+template <class _DistType>
+inline
+auto matsulib::Array <_T, _Allocator>::inject(_DistType initial_value, std::function <_DistType(_DistType accumulation, const _T &value)> func) const -> _DistType
+{
+  return inject_with_index <_DistType>(std::move(initial_value), [&func](_DistType accumulation, const _T &value, size_type) { return func(std::move(accumulation), value); });
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::inject(_T initial_value, std::function <_T(_T accumulation, const _T &value)> func) const -> _T
+{
+  return inject <_T>(std::move(initial_value), func);
+}
+
+template <class _T, class _Allocator>
+template <class _DistType>
+inline
+auto matsulib::Array <_T, _Allocator>::inject(std::function <_DistType(_DistType accumulation, const _T &value)> func) const -> _DistType
+{
+  return inject <_DistType>(_DistType{}, func);
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::inject(std::function <_T(_T accumulation, const _T &value)> func) const -> _T
+{
+  return inject <_T>(_T{}, func);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::each_with_index(std::function <void(const _T &value, size_type index)> func) const -> const Array <_T> &
+auto matsulib::Array <_T, _Allocator>::each_with_index(_Func &&func) const -> const Array <_T, _Allocator> &
 {
   const auto length = this->size();
+  const auto data = this->data();
   for (size_type i = 0; i < length; ++i)
   {
-    func(this->at(i), i);
+    func(data[i], i);
   }
   return *this;
 }
 
-template <class _T>
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::each_with_index(std::function <void(const _T &value, size_type index)> func) -> Array <_T> &
+auto matsulib::Array <_T, _Allocator>::each_with_index(_Func &&func) -> Array <_T, _Allocator> &
 {
-  return const_cast <Array <_T> &>(static_cast <const Array <_T> &>(*this).each_with_index(func));
+  return const_cast <Array <_T, _Allocator> &>(static_cast <const Array <_T, _Allocator> &>(*this).each_with_index(std::forward <_Func>(func)));
 }
 
-template <class _T>
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::each(std::function <void(const _T &value)> func) const -> const Array <_T> &
+auto matsulib::Array <_T, _Allocator>::each(_Func &&func) const -> const Array <_T, _Allocator> &
 {
-  return each_with_index(std::bind(func, std::placeholders::_1));
+  return each_with_index([&func](const _T &value, size_type) { func(value); });
 }
 
-template <class _T>
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::each(std::function <void(const _T &value)> func) -> Array <_T> &
+auto matsulib::Array <_T, _Allocator>::each(_Func &&func) -> Array <_T, _Allocator> &
 {
-  return each_with_index(std::bind(func, std::placeholders::_1));
+  return each_with_index([&func](const _T &value, size_type) { func(value); });
 }
 
-
-template <class _T>
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::transform_with_index(std::function <_T(_T value, size_type index)> func) -> Array <_T> &
+auto matsulib::Array <_T, _Allocator>::transform_with_index(_Func &&func) -> Array <_T, _Allocator> &
 {
   const auto length = this->size();
+  const auto data = this->data();
   for (size_type i = 0; i < length; ++i)
   {
-    this->at(i) = func(std::move(this->at(i)), i);
+    data[i] = func(std::move(data[i]), i);
   }
   return *this;
 }
 
-template <class _T>
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::transform(std::function <_T(_T value)> func) -> Array <_T> &
+auto matsulib::Array <_T, _Allocator>::transform(_Func &&func) -> Array <_T, _Allocator> &
 {
-  return transform_with_index(std::bind(func, std::placeholders::_1));
+  return transform_with_index([&func](_T value, size_type) { return func(std::move(value)); });
 }
 
-template <class _T>
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::select_with_index(std::function <bool(const _T &value, size_type index)> func) const -> Array <_T>
+auto matsulib::Array <_T, _Allocator>::select_with_index(_Func &&func) const -> Array <_T, _Allocator>
 {
   const auto length = this->size();
-  auto dst_array = Array <_T>{};
+  const auto data = this->data();
+  auto dst_array = Array <_T, _Allocator>(this->get_allocator());
   dst_array.reserve(length);
   for (size_type i = 0; i < length; ++i)
   {
-    if (func(this->at(i), i))
+    if (func(data[i], i))
     {
-      dst_array.push_back(this->at(i));
+      dst_array.push_back(data[i]);
     }
   }
   return dst_array;
 }
-template <class _T>
+
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::select(std::function <bool(const _T &value)> func) const -> Array <_T>
+auto matsulib::Array <_T, _Allocator>::select(_Func &&func) const -> Array <_T, _Allocator>
 {
-  return select_with_index(std::bind(func, std::placeholders::_1));
+  return select_with_index([&func](const _T &value, size_type) { return func(value); });
 }
 
-template <class _T>
-template <class _DistType>
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
 inline
-auto matsulib::Array <_T>::map_with_index(std::function <_DistType(const _T &value, size_type index)> func) const -> Array <_DistType>
+auto matsulib::Array <_T, _Allocator>::map_with_index(_Func &&func) const & -> array_of <_DistType>
 {
   const auto length = this->size();
-  auto dst_array = Array <_DistType>{};
-  dst_array.resize(length);
+  const auto data = this->data();
+  auto dst_array = array_of <_DistType>(typename array_of <_DistType>::allocator_type(this->get_allocator()));
+  dst_array.reserve(length);
   for (size_type i = 0; i < length; ++i)
   {
-    dst_array.at(i) = func(this->at(i), i);
+    dst_array.emplace_back(func(data[i], i));
   }
   return dst_array;
 }
 
-template <class _T>
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::map_with_index(std::function <_T(const _T &value, size_type index)> func) const -> Array <_T>
+auto matsulib::Array <_T, _Allocator>::map_with_index(_Func &&func) const & -> Array <_T, _Allocator>
 {
-  return map_with_index <_T>(func);
+  return map_with_index <_T>(std::forward <_Func>(func));
 }
 
-template <class _T>
-template <class _DistType>
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
 inline
-auto matsulib::Array <_T>::map(std::function <_DistType(const _T &value)> func) const -> Array <_DistType>
+auto matsulib::Array <_T, _Allocator>::map(_Func &&func) const & -> array_of <_DistType>
 {
-  return map_with_index <_DistType>(std::bind(func, std::placeholders::_1));
+  return map_with_index <_DistType>([&func](const _T &value, size_type) { return func(value); });
 }
 
-template <class _T>
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::map(std::function <_T(const _T &value)> func) const -> Array <_T>
+auto matsulib::Array <_T, _Allocator>::map(_Func &&func) const & -> Array <_T, _Allocator>
 {
-  return map_with_index(std::bind(func, std::placeholders::_1));
+  return map <_T>(std::forward <_Func>(func));
 }
 
-template <class _T>
-template <class _DistType>
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::map_with_index(_Func &&func) && -> _detail::array::DisableIfFunction <_Func, array_of <_DistType>>
+{
+  return map_with_index_consuming <_DistType>(std::forward <_Func>(func), std::is_same <array_of <_DistType>, Array <_T, _Allocator>>{});
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::map_with_index(_Func &&func) && -> _detail::array::DisableIfFunction <_Func, Array <_T, _Allocator>>
+{
+  return std::move(*this).template map_with_index <_T>(std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::map(_Func &&func) && -> _detail::array::DisableIfFunction <_Func, array_of <_DistType>>
+{
+  return std::move(*this).template map_with_index <_DistType>([&func](const _T &value, size_type) { return func(value); });
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::map(_Func &&func) && -> _detail::array::DisableIfFunction <_Func, Array <_T, _Allocator>>
+{
+  return std::move(*this).template map <_T>(std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
 inline
-auto matsulib::Array <_T>::inject_with_index(_DistType initial_value, std::function <_DistType(_DistType accumulation, const _T &value, size_type index)> func) const -> _DistType
+auto matsulib::Array <_T, _Allocator>::inject_with_index(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _detail::array::DisableIfFunction <_Func, _DistType>
 {
   auto accumulation = std::move(initial_value);
   const auto length = this->size();
+  const auto data = this->data();
   for (size_type i = 0; i < length; ++i)
   {
-    accumulation = func(std::move(accumulation), this->at(i), i);
+    accumulation = func(std::move(accumulation), data[i], i);
   }
   return accumulation;
 }
 
-template <class _T>
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::inject_with_index(_T initial_value, std::function <_T(_T accumulation, const _T &value, size_type index)> func) const -> _T
+auto matsulib::Array <_T, _Allocator>::inject_with_index(_T initial_value, _Func &&func) const -> _T
 {
-  return inject_with_index <_T>(std::move(initial_value), func);
+  return inject_with_index <_T>(std::move(initial_value), std::forward <_Func>(func));
 }
 
-template <class _T>
-template <class _DistType>
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
 inline
-auto matsulib::Array <_T>::inject(_DistType initial_value, std::function <_DistType(_DistType accumulation, const _T &value)> func) const -> _DistType
+auto matsulib::Array <_T, _Allocator>::inject(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _detail::array::DisableIfFunction <_Func, _DistType>
 {
-  return inject_with_index <_DistType>(std::move(initial_value), std::bind(func, std::placeholders::_1, std::placeholders::_2));
+  return inject_with_index <_DistType>(std::move(initial_value), [&func](_DistType accumulation, const _T &value, size_type) { return func(std::move(accumulation), value); });
 }
 
-template <class _T>
+template <class _T, class _Allocator>
+template <class _Func>
 inline
-auto matsulib::Array <_T>::inject(_T initial_value, std::function <_T(_T accumulation, const _T &value)> func) const -> _T
+auto matsulib::Array <_T, _Allocator>::inject(_T initial_value, _Func &&func) const -> _T
 {
-  return inject_with_index(std::move(initial_value), std::bind(func, std::placeholders::_1, std::placeholders::_2));
+  return inject <_T>(std::move(initial_value), std::forward <_Func>(func));
 }
 
-template <class _T>
-template <class _DistType>
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::inject(_Func &&func) const -> _DistType
+{
+  return inject <_DistType>(_DistType{}, std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::inject(_Func &&func) const -> _T
+{
+  return inject <_T>(_T{}, std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::transform_with_index(const execution::ParallelPolicy &policy, _Func &&func) -> Array <_T, _Allocator> &
+{
+  const auto length = this->size();
+  const auto data = this->data();
+  _detail::execution::run_chunks(_detail::execution::num_of_chunks(policy, length), length, [&](std::size_t, size_type begin, size_type end)
+  {
+    for (size_type i = begin; i < end; ++i)
+    {
+      data[i] = func(std::move(data[i]), i);
+    }
+  });
+  return *this;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::transform(const execution::ParallelPolicy &policy, _Func &&func) -> Array <_T, _Allocator> &
+{
+  return transform_with_index(policy, [&func](_T value, size_type) { return func(std::move(value)); });
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::select_with_index(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>
+{
+  const auto length = this->size();
+  const auto data = this->data();
+  const auto num_of_chunks = _detail::execution::num_of_chunks(policy, length);
+
+  // count : remember each verdict so that func is called only once per element
+  auto selected = std::vector <unsigned char>(length);
+  auto offsets = std::vector <size_type>(num_of_chunks + 1);
+  _detail::execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, size_type begin, size_type end)
+  {
+    size_type count = 0;
+    for (size_type i = begin; i < end; ++i)
+    {
+      selected[i] = func(data[i], i) ? 1 : 0;
+      count += selected[i];
+    }
+    offsets[chunk + 1] = count;
+  });
+  for (std::size_t chunk = 0; chunk < num_of_chunks; ++chunk)
+  {
+    offsets[chunk + 1] += offsets[chunk];
+  }
+
+  // scatter : every chunk writes to its own range, so the order is preserved
+  auto dst_array = Array <_T, _Allocator>(this->get_allocator());
+  dst_array.resize(offsets[num_of_chunks]);
+  const auto dst_data = dst_array.data();
+  _detail::execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, size_type begin, size_type end)
+  {
+    auto dst_index = offsets[chunk];
+    for (size_type i = begin; i < end; ++i)
+    {
+      if (selected[i])
+      {
+        dst_data[dst_index++] = data[i];
+      }
+    }
+  });
+  return dst_array;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::select(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>
+{
+  return select_with_index(policy, [&func](const _T &value, size_type) { return func(value); });
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::map_with_index(const execution::ParallelPolicy &policy, _Func &&func) const -> array_of <_DistType>
+{
+  const auto length = this->size();
+  const auto data = this->data();
+  auto dst_array = array_of <_DistType>(typename array_of <_DistType>::allocator_type(this->get_allocator()));
+  _detail::array::parallel_map(_detail::execution::num_of_chunks(policy, length), length, dst_array, [&](size_type i) { return func(data[i], i); });
+  return dst_array;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::map_with_index(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>
+{
+  return map_with_index <_T>(policy, std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::map(const execution::ParallelPolicy &policy, _Func &&func) const -> array_of <_DistType>
+{
+  return map_with_index <_DistType>(policy, [&func](const _T &value, size_type) { return func(value); });
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::map(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>
+{
+  return map <_T>(policy, std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::inject_with_index(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> _DistType
+{
+  const auto length = this->size();
+  const auto data = this->data();
+  const auto num_of_chunks = _detail::execution::num_of_chunks(policy, length);
+  if (num_of_chunks == 0)
+  {
+    return initial_value;
+  }
+
+  auto accumulations = std::vector <_DistType>(num_of_chunks, initial_value);
+  _detail::execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, size_type begin, size_type end)
+  {
+    auto accumulation = std::move(accumulations[chunk]);
+    for (size_type i = begin; i < end; ++i)
+    {
+      accumulation = func(std::move(accumulation), data[i], i);
+    }
+    accumulations[chunk] = std::move(accumulation);
+  });
+  for (std::size_t step = 1; step < num_of_chunks; step *= 2)
+  {
+    for (std::size_t chunk = 0; chunk + step < num_of_chunks; chunk += step * 2)
+    {
+      accumulations[chunk] = combine(std::move(accumulations[chunk]), std::move(accumulations[chunk + step]));
+    }
+  }
+  return std::move(accumulations[0]);
+}
+
+template <class _T, class _Allocator>
+template <class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::inject_with_index(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> _T
+{
+  return inject_with_index <_T>(policy, std::move(initial_value), std::forward <_Func>(func), std::forward <_Combine>(combine));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::inject(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> _DistType
+{
+  return inject_with_index <_DistType>(policy, std::move(initial_value), [&func](_DistType accumulation, const _T &value, size_type) { return func(std::move(accumulation), value); }, std::forward <_Combine>(combine));
+}
+
+template <class _T, class _Allocator>
+template <class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::inject(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> _T
+{
+  return inject <_T>(policy, std::move(initial_value), std::forward <_Func>(func), std::forward <_Combine>(combine));
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::sum() const -> typename simd::SumType <_T>::type
+{
+  return sum_impl(1);
+}
+
+template <class _T, class _Allocator>
 inline
-auto matsulib::Array <_T>::inject(std::function <_DistType(_DistType accumulation, const _T &value)> func) const -> _DistType
+auto matsulib::Array <_T, _Allocator>::dot(const Array <_T, _Allocator> &other) const -> typename simd::SumType <_T>::type
 {
-  return inject <_DistType>({}, func);
+  if (this->size() != other.size())
+  {
+    throw std::invalid_argument{ "matsulib::Array::dot() : Size Mismatch!!" };
+  }
+  return _detail::simd::Kernels <_T>::dot(this->data(), other.data(), this->size());
 }
 
-template <class _T>
+template <class _T, class _Allocator>
 inline
-auto matsulib::Array <_T>::inject(std::function <_T(_T accumulation, const _T &value)> func) const -> _T
+auto matsulib::Array <_T, _Allocator>::min() const -> _T
 {
-  return inject({}, func);
-}
\ No newline at end of file
+  return minmax().first;
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::max() const -> _T
+{
+  return minmax().second;
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::minmax() const -> std::pair <_T, _T>
+{
+  if (this->empty())
+  {
+    throw std::out_of_range{ "matsulib::Array::minmax() : Empty Array!!" };
+  }
+  auto result = std::pair <_T, _T>{};
+  _detail::simd::Kernels <_T>::min_max(this->data(), this->size(), result.first, result.second);
+  return result;
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::count_if(simd::Compare compare, const _T &value) const -> size_type
+{
+  return _detail::simd::Kernels <_T>::count(this->data(), this->size(), compare, value);
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::add(const Array <_T, _Allocator> &other) -> Array <_T, _Allocator> &
+{
+  if (this->size() != other.size())
+  {
+    throw std::invalid_argument{ "matsulib::Array::add() : Size Mismatch!!" };
+  }
+  _detail::simd::Kernels <_T>::add(this->data(), other.data(), this->size());
+  return *this;
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::mul(const Array <_T, _Allocator> &other) -> Array <_T, _Allocator> &
+{
+  if (this->size() != other.size())
+  {
+    throw std::invalid_argument{ "matsulib::Array::mul() : Size Mismatch!!" };
+  }
+  _detail::simd::Kernels <_T>::mul(this->data(), other.data(), this->size());
+  return *this;
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::scale(const _T &factor) -> Array <_T, _Allocator> &
+{
+  _detail::simd::Kernels <_T>::scale(this->data(), factor, this->size());
+  return *this;
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::clamp(const _T &low, const _T &high) -> Array <_T, _Allocator> &
+{
+  _detail::simd::Kernels <_T>::clamp(this->data(), low, high, this->size());
+  return *this;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::keep_if_with_index(_Func &&func, bool shrink) -> Array <_T, _Allocator> &
+{
+  const auto length = this->size();
+  const auto data = this->data();
+  size_type kept = 0;
+  for (size_type i = 0; i < length; ++i)
+  {
+    if (func(static_cast <const _T &>(data[i]), i))
+    {
+      if (kept != i)
+      {
+        data[kept] = std::move(data[i]);
+      }
+      ++kept;
+    }
+  }
+  this->erase(this->begin() + kept, this->end());
+  if (shrink)
+  {
+    this->shrink_to_fit();
+  }
+  return *this;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::keep_if(_Func &&func, bool shrink) -> Array <_T, _Allocator> &
+{
+  return keep_if_with_index([&func](const _T &value, size_type) { return func(value); }, shrink);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::delete_if_with_index(_Func &&func, bool shrink) -> Array <_T, _Allocator> &
+{
+  return keep_if_with_index([&func](const _T &value, size_type index) { return !func(value, index); }, shrink);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::delete_if(_Func &&func, bool shrink) -> Array <_T, _Allocator> &
+{
+  return keep_if_with_index([&func](const _T &value, size_type) { return !func(value); }, shrink);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::partition(_Func &&func) -> size_type
+{
+  const auto middle = std::partition(this->begin(), this->end(), [&func](const _T &value) { return static_cast <bool>(func(value)); });
+  return static_cast <size_type>(middle - this->begin());
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::stable_partition(_Func &&func) -> size_type
+{
+  const auto middle = std::stable_partition(this->begin(), this->end(), [&func](const _T &value) { return static_cast <bool>(func(value)); });
+  return static_cast <size_type>(middle - this->begin());
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::map_with_index_consuming(_Func &&func, std::true_type) -> array_of <_DistType>
+{
+  const auto length = this->size();
+  const auto data = this->data();
+  for (size_type i = 0; i < length; ++i)
+  {
+    data[i] = func(static_cast <const _T &>(data[i]), i);
+  }
+  return std::move(*this);
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::map_with_index_consuming(_Func &&func, std::false_type) -> array_of <_DistType>
+{
+  return static_cast <const Array <_T, _Allocator> &>(*this).template map_with_index <_DistType>(std::forward <_Func>(func));
+}
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::sort() -> Array <_T, _Allocator> &
+{
+  _detail::sort::sort_values(this->data(), this->size(), 1);
+  return *this;
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::sort(const execution::ParallelPolicy &policy) -> Array <_T, _Allocator> &
+{
+  _detail::sort::sort_values(this->data(), this->size(), _detail::execution::num_of_chunks(policy, this->size()));
+  return *this;
+}
+
+template <class _T, class _Allocator>
+template <class _Compare>
+inline
+auto matsulib::Array <_T, _Allocator>::sort(_Compare &&compare) -> _detail::array::DisableIfPolicy <_Compare, Array <_T, _Allocator> &>
+{
+  _detail::sort::merge_sort(this->data(), this->size(), compare, false, 1);
+  return *this;
+}
+
+template <class _T, class _Allocator>
+template <class _Compare>
+inline
+auto matsulib::Array <_T, _Allocator>::sort(const execution::ParallelPolicy &policy, _Compare &&compare) -> _detail::array::DisableIfPolicy <_Compare, Array <_T, _Allocator> &>
+{
+  _detail::sort::merge_sort(this->data(), this->size(), compare, false, _detail::execution::num_of_chunks(policy, this->size()));
+  return *this;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::sort_by(_Func &&key_of) -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator> &>
+{
+  _detail::sort::sort_by(this->data(), this->size(), key_of, false, 1);
+  return *this;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::sort_by(const execution::ParallelPolicy &policy, _Func &&key_of) -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator> &>
+{
+  _detail::sort::sort_by(this->data(), this->size(), key_of, false, _detail::execution::num_of_chunks(policy, this->size()));
+  return *this;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::stable_sort_by(_Func &&key_of) -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator> &>
+{
+  _detail::sort::sort_by(this->data(), this->size(), key_of, true, 1);
+  return *this;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::stable_sort_by(const execution::ParallelPolicy &policy, _Func &&key_of) -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator> &>
+{
+  _detail::sort::sort_by(this->data(), this->size(), key_of, true, _detail::execution::num_of_chunks(policy, this->size()));
+  return *this;
+}
+
+template <class _T, class _Allocator>
+template <class _Key, class _Value, class _Func, class _Emplace>
+inline
+auto matsulib::Array <_T, _Allocator>::hash_group(std::size_t num_of_chunks, _Func &key_of, _Emplace emplace) const -> FlatHashMap <_Key, _Value>
+{
+  const auto length = this->size();
+  const auto data = this->data();
+  if (num_of_chunks <= 1)
+  {
+    auto groups = FlatHashMap <_Key, _Value>{};
+    for (size_type i = 0; i < length; ++i)
+    {
+      emplace(groups, key_of(data[i]), data[i], i);
+    }
+    return groups;
+  }
+
+  // partition : high bits of the hash (the tables probe with the low bits), indices stay in order within a partition
+  const auto num_of_partitions = num_of_chunks;
+  auto partitions = std::vector <std::size_t>(length);
+  auto offsets = std::vector <size_type>(num_of_chunks * num_of_partitions);
+  auto hash = std::hash <_Key>{};
+  _detail::execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, size_type begin, size_type end)
+  {
+    const auto counts = offsets.data() + chunk * num_of_partitions;
+    for (size_type i = begin; i < end; ++i)
+    {
+      // top 32 bits of the size_t-wide hash, scaled to [0, num_of_partitions)
+      const auto top = static_cast <unsigned long long>(_detail::flat_hash_map::mix(hash(key_of(data[i]))) >> (sizeof(std::size_t) * 8 - 32));
+      partitions[i] = static_cast <std::size_t>((top * num_of_partitions) >> 32);
+      ++counts[partitions[i]];
+    }
+  });
+  auto partition_begin = std::vector <size_type>(num_of_partitions + 1);
+  size_type offset = 0;
+  for (std::size_t partition = 0; partition < num_of_partitions; ++partition)
+  {
+    partition_begin[partition] = offset;
+    for (std::size_t chunk = 0; chunk < num_of_chunks; ++chunk)
+    {
+      const auto count = offsets[chunk * num_of_partitions + partition];
+      offsets[chunk * num_of_partitions + partition] = offset;
+      offset += count;
+    }
+  }
+  partition_begin[num_of_partitions] = length;
+  auto order = std::vector <size_type>(length);
+  _detail::execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, size_type begin, size_type end)
+  {
+    const auto positions = offsets.data() + chunk * num_of_partitions;
+    for (size_type i = begin; i < end; ++i)
+    {
+      order[positions[partitions[i]]++] = i;
+    }
+  });
+
+  // build : one table per partition, remembering where each group first appeared
+  auto tables = std::vector <FlatHashMap <_Key, _Value>>(num_of_partitions);
+  auto firsts = std::vector <std::vector <size_type>>(num_of_partitions);
+  _detail::execution::run_chunks(num_of_partitions, num_of_partitions, [&](std::size_t partition, size_type, size_type)
+  {
+    for (auto position = partition_begin[partition]; position < partition_begin[partition + 1]; ++position)
+    {
+      const auto i = order[position];
+      if (emplace(tables[partition], key_of(data[i]), data[i], i))
+      {
+        firsts[partition].push_back(i);
+      }
+    }
+  });
+
+  // merge : the partitions hold disjoint keys, so only the order of first appearance has to be restored
+  auto entries = std::vector <std::pair <size_type, std::pair <std::size_t, size_type>>>{};
+  for (std::size_t partition = 0; partition < num_of_partitions; ++partition)
+  {
+    for (size_type entry = 0; entry < firsts[partition].size(); ++entry)
+    {
+      entries.emplace_back(firsts[partition][entry], std::make_pair(partition, entry));
+    }
+  }
+  std::sort(entries.begin(), entries.end());
+  auto groups = FlatHashMap <_Key, _Value>(entries.size());
+  for (const auto &entry : entries)
+  {
+    auto &group = *(tables[entry.second.first].begin() + entry.second.second);
+    groups.try_emplace(std::move(group.first), std::move(group.second));
+  }
+  return groups;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::group_by(_Func &&key_of) const -> FlatHashMap <key_of_t <_Func>, Array <_T, _Allocator>>
+{
+  return hash_group <key_of_t <_Func>, Array <_T, _Allocator>>(1, key_of, _detail::array::GroupEmplace <_Allocator>{ this->get_allocator() });
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::group_by(const execution::ParallelPolicy &policy, _Func &&key_of) const -> FlatHashMap <key_of_t <_Func>, Array <_T, _Allocator>>
+{
+  return hash_group <key_of_t <_Func>, Array <_T, _Allocator>>(_detail::execution::num_of_chunks(policy, this->size()), key_of, _detail::array::GroupEmplace <_Allocator>{ this->get_allocator() });
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::tally() const -> FlatHashMap <_T, size_type>
+{
+  auto key_of = _detail::array::Self{};
+  return hash_group <_T, size_type>(1, key_of, _detail::array::CountEmplace{});
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::tally(const execution::ParallelPolicy &policy) const -> FlatHashMap <_T, size_type>
+{
+  auto key_of = _detail::array::Self{};
+  return hash_group <_T, size_type>(_detail::execution::num_of_chunks(policy, this->size()), key_of, _detail::array::CountEmplace{});
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::index_by(_Func &&key_of) const -> FlatHashMap <key_of_t <_Func>, _T>
+{
+  return hash_group <key_of_t <_Func>, _T>(1, key_of, _detail::array::LastEmplace{});
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::index_by(const execution::ParallelPolicy &policy, _Func &&key_of) const -> FlatHashMap <key_of_t <_Func>, _T>
+{
+  return hash_group <key_of_t <_Func>, _T>(_detail::execution::num_of_chunks(policy, this->size()), key_of, _detail::array::LastEmplace{});
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::uniq() const -> Array <_T, _Allocator>
+{
+  auto key_of = _detail::array::Self{};
+  return uniq_impl(1, key_of);
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::uniq(const execution::ParallelPolicy &policy) const -> Array <_T, _Allocator>
+{
+  auto key_of = _detail::array::Self{};
+  return uniq_impl(_detail::execution::num_of_chunks(policy, this->size()), key_of);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::uniq(_Func &&key_of) const -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator>>
+{
+  return uniq_impl(1, key_of);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::uniq(const execution::ParallelPolicy &policy, _Func &&key_of) const -> _detail::array::DisableIfPolicy <_Func, Array <_T, _Allocator>>
+{
+  return uniq_impl(_detail::execution::num_of_chunks(policy, this->size()), key_of);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::uniq_impl(std::size_t num_of_chunks, _Func &key_of) const -> Array <_T, _Allocator>
+{
+  const auto firsts = hash_group <key_of_t <_Func>, size_type>(num_of_chunks, key_of, _detail::array::FirstIndexEmplace{});
+  const auto data = this->data();
+  auto dst_array = Array <_T, _Allocator>(this->get_allocator());
+  dst_array.reserve(firsts.size());
+  for (const auto &first : firsts)
+  {
+    dst_array.push_back(data[first.second]);
+  }
+  return dst_array;
+}
+
+template <class _T, class _Allocator>
+constexpr typename matsulib::Array <_T, _Allocator>::size_type matsulib::Array <_T, _Allocator>::npos;
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::find_index_impl(std::size_t num_of_chunks, _Func &func, bool lowest) const -> size_type
+{
+  const auto length = this->size();
+  const auto data = this->data();
+  if (num_of_chunks <= 1)
+  {
+    for (size_type i = 0; i < length; ++i)
+    {
+      if (func(data[i]))
+      {
+        return i;
+      }
+    }
+    return npos;
+  }
+
+  // every chunk stops at its first match, or as soon as a lower match is known (checked once per block) ;
+  // without lowest, as soon as any chunk has matched (done)
+  constexpr size_type BLOCK = 1024;
+  std::atomic <size_type> found{ npos };
+  std::atomic <bool> done{ false };
+  _detail::execution::run_chunks(num_of_chunks, length, [&](std::size_t, size_type begin, size_type end)
+  {
+    for (auto block = begin; block < end; block += BLOCK)
+    {
+      if (lowest ? found.load(std::memory_order_relaxed) < block : done.load(std::memory_order_relaxed))
+      {
+        return;
+      }
+      const auto block_end = end - block < BLOCK ? end : block + BLOCK;
+      for (auto i = block; i < block_end; ++i)
+      {
+        if (func(data[i]))
+        {
+          auto known = found.load(std::memory_order_relaxed);
+          while (i < known && !found.compare_exchange_weak(known, i, std::memory_order_relaxed))
+          {
+          }
+          done.store(true, std::memory_order_relaxed);
+          return;
+        }
+      }
+    }
+  });
+  return found.load();
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::any(_Func &&func) const -> bool
+{
+  return find_index_impl(1, func, false) != npos;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::any(const execution::ParallelPolicy &policy, _Func &&func) const -> bool
+{
+  return find_index_impl(_detail::execution::num_of_chunks(policy, this->size()), func, false) != npos;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::all(_Func &&func) const -> bool
+{
+  auto fails = [&func](const _T &value) { return !func(value); };
+  return find_index_impl(1, fails, false) == npos;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::all(const execution::ParallelPolicy &policy, _Func &&func) const -> bool
+{
+  auto fails = [&func](const _T &value) { return !func(value); };
+  return find_index_impl(_detail::execution::num_of_chunks(policy, this->size()), fails, false) == npos;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::none(_Func &&func) const -> bool
+{
+  return !any(std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::none(const execution::ParallelPolicy &policy, _Func &&func) const -> bool
+{
+  return !any(policy, std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::find_index(_Func &&func) const -> size_type
+{
+  return find_index_impl(1, func, true);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::find_index(const execution::ParallelPolicy &policy, _Func &&func) const -> size_type
+{
+  return find_index_impl(_detail::execution::num_of_chunks(policy, this->size()), func, true);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::find(_Func &&func) const -> const_iterator
+{
+  const auto index = find_index(std::forward <_Func>(func));
+  return index == npos ? this->end() : this->begin() + index;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::find(const execution::ParallelPolicy &policy, _Func &&func) const -> const_iterator
+{
+  const auto index = find_index(policy, std::forward <_Func>(func));
+  return index == npos ? this->end() : this->begin() + index;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::take_while(_Func &&func) const -> Array <_T, _Allocator>
+{
+  const auto index = find_index([&func](const _T &value) { return !func(value); });
+  return Array <_T, _Allocator>(this->begin(), index == npos ? this->end() : this->begin() + index, this->get_allocator());
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::take_while(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>
+{
+  const auto index = find_index(policy, [&func](const _T &value) { return !func(value); });
+  return Array <_T, _Allocator>(this->begin(), index == npos ? this->end() : this->begin() + index, this->get_allocator());
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::drop_while(_Func &&func) const -> Array <_T, _Allocator>
+{
+  const auto index = find_index([&func](const _T &value) { return !func(value); });
+  return Array <_T, _Allocator>(index == npos ? this->end() : this->begin() + index, this->end(), this->get_allocator());
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::drop_while(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_T, _Allocator>
+{
+  const auto index = find_index(policy, [&func](const _T &value) { return !func(value); });
+  return Array <_T, _Allocator>(index == npos ? this->end() : this->begin() + index, this->end(), this->get_allocator());
+}
+
+template <class _T, class _Allocator>
+constexpr typename matsulib::Array <_T, _Allocator>::size_type matsulib::Array <_T, _Allocator>::REDUCE_BLOCK;
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Block, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::blocked_reduce(std::size_t num_of_chunks, _DistType identity, _Block &&block_func, _Combine &&combine) const -> _DistType
+{
+  const auto length = this->size();
+  const auto num_of_blocks = (length + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+  if (num_of_blocks == 0)
+  {
+    return identity;
+  }
+  auto partials = std::vector <_DistType>(num_of_blocks, identity);
+  _detail::execution::run_chunks(num_of_chunks < num_of_blocks ? num_of_chunks : num_of_blocks, num_of_blocks, [&](std::size_t, size_type begin, size_type end)
+  {
+    for (auto block = begin; block < end; ++block)
+    {
+      const auto last = (block + 1) * REDUCE_BLOCK;
+      partials[block] = block_func(block * REDUCE_BLOCK, last < length ? last : length);
+    }
+  });
+  // the shape of the tree only depends on the number of blocks
+  for (size_type width = 1; width < num_of_blocks; width *= 2)
+  {
+    for (size_type i = 0; i + width < num_of_blocks; i += width * 2)
+    {
+      partials[i] = combine(std::move(partials[i]), std::move(partials[i + width]));
+    }
+  }
+  return partials[0];
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::sum(const execution::ParallelPolicy &policy) const -> typename simd::SumType <_T>::type
+{
+  return sum_impl(_detail::execution::num_of_chunks(policy, this->size()));
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::sum_impl(std::size_t num_of_chunks) const -> typename simd::SumType <_T>::type
+{
+  using sum_type = typename simd::SumType <_T>::type;
+  const auto data = this->data();
+  return blocked_reduce(num_of_chunks, sum_type{},
+    [data](size_type begin, size_type end) { return _detail::simd::Kernels <_T>::sum(data + begin, end - begin); },
+    [](sum_type lhs, sum_type rhs) { return lhs + rhs; });
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::compensated_sum() const -> typename simd::SumType <_T>::type
+{
+  return compensated_sum_impl(1);
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::compensated_sum(const execution::ParallelPolicy &policy) const -> typename simd::SumType <_T>::type
+{
+  return compensated_sum_impl(_detail::execution::num_of_chunks(policy, this->size()));
+}
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::compensated_sum_impl(std::size_t num_of_chunks) const -> typename simd::SumType <_T>::type
+{
+  using sum_type = typename simd::SumType <_T>::type;
+  using compensated_type = _detail::array::CompensatedSum <sum_type>;
+  const auto data = this->data();
+  const auto total = blocked_reduce(num_of_chunks, compensated_type{ sum_type{}, sum_type{} },
+    [data](size_type begin, size_type end)
+    {
+      auto block = compensated_type{ sum_type{}, sum_type{} };
+      for (auto i = begin; i < end; ++i)
+      {
+        block.add(static_cast <sum_type>(data[i]));
+      }
+      return block;
+    },
+    [](const compensated_type &lhs, const compensated_type &rhs) { return lhs.join(rhs); });
+  return total.sum + total.compensation;
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::reduce(_T identity, _Func &&func) const -> _T
+{
+  return reduce_impl(1, std::move(identity), func);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::reduce(const execution::ParallelPolicy &policy, _T identity, _Func &&func) const -> _T
+{
+  return reduce_impl(_detail::execution::num_of_chunks(policy, this->size()), std::move(identity), func);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::reduce_impl(std::size_t num_of_chunks, _T identity, _Func &func) const -> _T
+{
+  const auto data = this->data();
+  return blocked_reduce(num_of_chunks, identity,
+    [&](size_type begin, size_type end)
+    {
+      auto accumulation = identity;
+      for (auto i = begin; i < end; ++i)
+      {
+        accumulation = func(std::move(accumulation), data[i]);
+      }
+      return accumulation;
+    },
+    func);
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::scan_with_index(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> array_of <_DistType>
+{
+  return scan_impl <_DistType>(std::move(initial_value), func, false);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::scan_with_index(_T initial_value, _Func &&func) const -> Array <_T, _Allocator>
+{
+  return scan_with_index <_T>(std::move(initial_value), std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::scan(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> array_of <_DistType>
+{
+  return scan_with_index <_DistType>(std::move(initial_value), [&func](_DistType accumulation, const _T &value, size_type) { return func(std::move(accumulation), value); });
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::scan(_T initial_value, _Func &&func) const -> Array <_T, _Allocator>
+{
+  return scan <_T>(std::move(initial_value), std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::scan_with_index(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> array_of <_DistType>
+{
+  return scan_impl <_DistType>(policy, std::move(initial_value), func, combine, false);
+}
+
+template <class _T, class _Allocator>
+template <class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::scan_with_index(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> Array <_T, _Allocator>
+{
+  return scan_with_index <_T>(policy, std::move(initial_value), std::forward <_Func>(func), std::forward <_Combine>(combine));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::scan(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> array_of <_DistType>
+{
+  return scan_with_index <_DistType>(policy, std::move(initial_value), [&func](_DistType accumulation, const _T &value, size_type) { return func(std::move(accumulation), value); }, std::forward <_Combine>(combine));
+}
+
+template <class _T, class _Allocator>
+template <class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::scan(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> Array <_T, _Allocator>
+{
+  return scan <_T>(policy, std::move(initial_value), std::forward <_Func>(func), std::forward <_Combine>(combine));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::exclusive_scan_with_index(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> array_of <_DistType>
+{
+  return scan_impl <_DistType>(std::move(initial_value), func, true);
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::exclusive_scan_with_index(_T initial_value, _Func &&func) const -> Array <_T, _Allocator>
+{
+  return exclusive_scan_with_index <_T>(std::move(initial_value), std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::exclusive_scan(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> array_of <_DistType>
+{
+  return exclusive_scan_with_index <_DistType>(std::move(initial_value), [&func](_DistType accumulation, const _T &value, size_type) { return func(std::move(accumulation), value); });
+}
+
+template <class _T, class _Allocator>
+template <class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::exclusive_scan(_T initial_value, _Func &&func) const -> Array <_T, _Allocator>
+{
+  return exclusive_scan <_T>(std::move(initial_value), std::forward <_Func>(func));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::exclusive_scan_with_index(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> array_of <_DistType>
+{
+  return scan_impl <_DistType>(policy, std::move(initial_value), func, combine, true);
+}
+
+template <class _T, class _Allocator>
+template <class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::exclusive_scan_with_index(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> Array <_T, _Allocator>
+{
+  return exclusive_scan_with_index <_T>(policy, std::move(initial_value), std::forward <_Func>(func), std::forward <_Combine>(combine));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::exclusive_scan(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> array_of <_DistType>
+{
+  return exclusive_scan_with_index <_DistType>(policy, std::move(initial_value), [&func](_DistType accumulation, const _T &value, size_type) { return func(std::move(accumulation), value); }, std::forward <_Combine>(combine));
+}
+
+template <class _T, class _Allocator>
+template <class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::exclusive_scan(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> Array <_T, _Allocator>
+{
+  return exclusive_scan <_T>(policy, std::move(initial_value), std::forward <_Func>(func), std::forward <_Combine>(combine));
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func>
+inline
+auto matsulib::Array <_T, _Allocator>::scan_impl(_DistType initial_value, _Func &func, bool exclusive) const -> array_of <_DistType>
+{
+  const auto length = this->size();
+  const auto data = this->data();
+  auto dst_array = array_of <_DistType>(typename array_of <_DistType>::allocator_type(this->get_allocator()));
+  dst_array.reserve(length);
+  auto accumulation = std::move(initial_value);
+  for (size_type i = 0; i < length; ++i)
+  {
+    if (exclusive)
+    {
+      dst_array.push_back(accumulation);
+      accumulation = func(std::move(accumulation), data[i], i);
+    }
+    else
+    {
+      accumulation = func(std::move(accumulation), data[i], i);
+      dst_array.push_back(accumulation);
+    }
+  }
+  return dst_array;
+}
+
+template <class _T, class _Allocator>
+template <class _DistType, class _Func, class _Combine>
+inline
+auto matsulib::Array <_T, _Allocator>::scan_impl(const execution::ParallelPolicy &policy, _DistType initial_value, _Func &func, _Combine &combine, bool exclusive) const -> array_of <_DistType>
+{
+  const auto length = this->size();
+  const auto data = this->data();
+  const auto num_of_chunks = _detail::execution::num_of_chunks(policy, length);
+  auto dst_array = array_of <_DistType>(typename array_of <_DistType>::allocator_type(this->get_allocator()));
+  dst_array.resize(length);
+  const auto dst_data = dst_array.data();
+
+  // pass 1 : total of every chunk
+  auto prefixes = std::vector <_DistType>(num_of_chunks + 1, initial_value);
+  _detail::execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, size_type begin, size_type end)
+  {
+    auto accumulation = initial_value;
+    for (size_type i = begin; i < end; ++i)
+    {
+      accumulation = func(std::move(accumulation), data[i], i);
+    }
+    prefixes[chunk + 1] = std::move(accumulation);
+  });
+  for (std::size_t chunk = 0; chunk < num_of_chunks; ++chunk)
+  {
+    prefixes[chunk + 1] = combine(prefixes[chunk], std::move(prefixes[chunk + 1]));
+  }
+
+  // pass 2 : rescan every chunk from the accumulation of everything before it
+  _detail::execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, size_type begin, size_type end)
+  {
+    auto accumulation = prefixes[chunk];
+    for (size_type i = begin; i < end; ++i)
+    {
+      if (exclusive)
+      {
+        dst_data[i] = accumulation;
+        accumulation = func(std::move(accumulation), data[i], i);
+      }
+      else
+      {
+        accumulation = func(std::move(accumulation), data[i], i);
+        dst_data[i] = accumulation;
+      }
+    }
+  });
+  return dst_array;
+}
+
+#include "lazy_array.hpp"
+#include "flat_hash_map.hpp"
\ No newline at end of file
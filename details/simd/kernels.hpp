@@ -0,0 +1,189 @@
+﻿// No include guard : simd.hpp includes this file once per instruction set, inside a namespace
+// (matsulib::_detail::simd::sse2 / avx2) with MATSULIB_SIMD_KERNEL set to the matching target attribute.
+// _V is a vector traits struct (Sse2F32, Avx2U8, ...) defined in simd.hpp.
+// Loops are written over matsulib::simd_range : full blocks of _V::lanes elements, then a scalar tail.
+
+template <class _V>
+MATSULIB_SIMD_KERNEL inline auto sum(const typename _V::value_type *data, std::size_t length) -> typename _V::sum_type
+{
+  const auto range = matsulib::simd_range <_V::lanes>(length);
+  auto accumulation = _V::acc_zero();
+  for (const auto i : range)
+  {
+    accumulation = _V::acc_add(accumulation, _V::load(data + i));
+  }
+  auto result = _V::acc_reduce(accumulation);
+  for (const auto i : range.tail())
+  {
+    result += data[i];
+  }
+  return result;
+}
+
+template <class _V>
+MATSULIB_SIMD_KERNEL inline auto dot(const typename _V::value_type *lhs, const typename _V::value_type *rhs, std::size_t length) -> typename _V::sum_type
+{
+  using sum_type = typename _V::sum_type;
+  const auto range = matsulib::simd_range <_V::lanes>(length);
+  auto accumulation = _V::acc_zero();
+  for (const auto i : range)
+  {
+    accumulation = _V::acc_dot(accumulation, _V::load(lhs + i), _V::load(rhs + i));
+  }
+  auto result = _V::acc_reduce(accumulation);
+  for (const auto i : range.tail())
+  {
+    result += static_cast <sum_type>(lhs[i]) * static_cast <sum_type>(rhs[i]);
+  }
+  return result;
+}
+
+// length must be > 0
+// Seeded with an element that is not NaN ; min(vector, accumulator) returns the accumulator for a NaN lane, so NaNs are skipped.
+template <class _V>
+MATSULIB_SIMD_KERNEL inline auto min_max(const typename _V::value_type *data, std::size_t length, typename _V::value_type &min_value, typename _V::value_type &max_value) -> void
+{
+  using value_type = typename _V::value_type;
+  min_value = max_value = data[first_ordered(data, length)];
+  const auto range = matsulib::simd_range <_V::lanes>(length);
+  if (range.num_of_blocks() != 0)
+  {
+    auto min_vector = _V::set1(min_value);
+    auto max_vector = min_vector;
+    for (const auto i : range)
+    {
+      const auto vector = _V::load(data + i);
+      min_vector = _V::min(vector, min_vector);
+      max_vector = _V::max(vector, max_vector);
+    }
+    value_type min_lanes[_V::lanes];
+    value_type max_lanes[_V::lanes];
+    _V::store(min_lanes, min_vector);
+    _V::store(max_lanes, max_vector);
+    for (std::size_t lane = 0; lane < _V::lanes; ++lane)
+    {
+      min_value = min_lanes[lane] < min_value ? min_lanes[lane] : min_value;
+      max_value = max_value < max_lanes[lane] ? max_lanes[lane] : max_value;
+    }
+  }
+  for (const auto i : range.tail())
+  {
+    min_value = data[i] < min_value ? data[i] : min_value;
+    max_value = max_value < data[i] ? data[i] : max_value;
+  }
+}
+
+template <class _V>
+MATSULIB_SIMD_KERNEL inline auto add(typename _V::value_type *dst, const typename _V::value_type *src, std::size_t length) -> void
+{
+  using value_type = typename _V::value_type;
+  // peeled so that the stores to dst are vector aligned
+  const auto range = matsulib::simd_range <_V::lanes>(length).peel(dst);
+  for (const auto i : range.head())
+  {
+    dst[i] = static_cast <value_type>(dst[i] + src[i]);
+  }
+  for (const auto i : range)
+  {
+    _V::store(dst + i, _V::add(_V::load(dst + i), _V::load(src + i)));
+  }
+  for (const auto i : range.tail())
+  {
+    dst[i] = static_cast <value_type>(dst[i] + src[i]);
+  }
+}
+
+template <class _V>
+MATSULIB_SIMD_KERNEL inline auto mul(typename _V::value_type *dst, const typename _V::value_type *src, std::size_t length) -> void
+{
+  using value_type = typename _V::value_type;
+  // peeled so that the stores to dst are vector aligned
+  const auto range = matsulib::simd_range <_V::lanes>(length).peel(dst);
+  for (const auto i : range.head())
+  {
+    dst[i] = static_cast <value_type>(dst[i] * src[i]);
+  }
+  for (const auto i : range)
+  {
+    _V::store(dst + i, _V::mul(_V::load(dst + i), _V::load(src + i)));
+  }
+  for (const auto i : range.tail())
+  {
+    dst[i] = static_cast <value_type>(dst[i] * src[i]);
+  }
+}
+
+template <class _V>
+MATSULIB_SIMD_KERNEL inline auto scale(typename _V::value_type *dst, typename _V::value_type factor, std::size_t length) -> void
+{
+  using value_type = typename _V::value_type;
+  const auto factor_vector = _V::set1(factor);
+  // peeled so that the stores to dst are vector aligned
+  const auto range = matsulib::simd_range <_V::lanes>(length).peel(dst);
+  for (const auto i : range.head())
+  {
+    dst[i] = static_cast <value_type>(dst[i] * factor);
+  }
+  for (const auto i : range)
+  {
+    _V::store(dst + i, _V::mul(_V::load(dst + i), factor_vector));
+  }
+  for (const auto i : range.tail())
+  {
+    dst[i] = static_cast <value_type>(dst[i] * factor);
+  }
+}
+
+template <class _V>
+MATSULIB_SIMD_KERNEL inline auto clamp(typename _V::value_type *dst, typename _V::value_type low, typename _V::value_type high, std::size_t length) -> void
+{
+  const auto low_vector = _V::set1(low);
+  const auto high_vector = _V::set1(high);
+  // peeled so that the stores to dst are vector aligned
+  const auto range = matsulib::simd_range <_V::lanes>(length).peel(dst);
+  for (const auto i : range.head())
+  {
+    const auto value = low < dst[i] ? dst[i] : low;
+    dst[i] = value < high ? value : high;
+  }
+  for (const auto i : range)
+  {
+    _V::store(dst + i, _V::min(_V::max(_V::load(dst + i), low_vector), high_vector));
+  }
+  for (const auto i : range.tail())
+  {
+    const auto value = low < dst[i] ? dst[i] : low;
+    dst[i] = value < high ? value : high;
+  }
+}
+
+template <class _V>
+MATSULIB_SIMD_KERNEL inline auto count(const typename _V::value_type *data, std::size_t length, matsulib::simd::Compare compare, typename _V::value_type value) -> std::size_t
+{
+  using matsulib::simd::Compare;
+  const auto value_vector = _V::set1(value);
+  const auto range = matsulib::simd_range <_V::lanes>(length);
+  std::size_t result = 0;
+  for (const auto i : range)
+  {
+    const auto vector = _V::load(data + i);
+    switch (compare)
+    {
+    case Compare::EQUAL:
+    case Compare::NOT_EQUAL:     result += _V::count_eq(vector, value_vector); break;
+    case Compare::LESS:          result += _V::count_lt(vector, value_vector); break;
+    case Compare::LESS_EQUAL:    result += _V::count_le(vector, value_vector); break;
+    case Compare::GREATER:       result += _V::count_lt(value_vector, vector); break;
+    case Compare::GREATER_EQUAL: result += _V::count_le(value_vector, vector); break;
+    }
+  }
+  if (compare == Compare::NOT_EQUAL)
+  {
+    result = range.num_of_blocks() * _V::lanes - result;
+  }
+  for (const auto i : range.tail())
+  {
+    result += matches(compare, data[i], value) ? 1 : 0;
+  }
+  return result;
+}
@@ -0,0 +1,330 @@
+﻿#pragma once
+
+#include "../execution.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace matsulib
+{
+  namespace _detail
+  {
+    namespace sort
+    {
+      // below this length the radix passes cost more than a comparison sort
+      constexpr std::size_t RADIX_THRESHOLD = 256;
+
+      // Order preserving map of integer / floating point values onto unsigned integers (bits).
+      template <class _T, class = void>
+      struct RadixKey
+      {
+        static constexpr bool enabled = false;
+      };
+      template <class _T>
+      struct RadixKey <_T, typename std::enable_if <std::is_integral <_T>::value && !std::is_same <_T, bool>::value>::type>
+      {
+        static constexpr bool enabled = true;
+        using bits_type = typename std::make_unsigned <_T>::type;
+        static auto to_bits(_T value) -> bits_type
+        {
+          // signed : flip the sign bit so that negative values come first
+          return static_cast <bits_type>(static_cast <bits_type>(value) ^ (std::is_signed <_T>::value ? static_cast <bits_type>(bits_type(1) << (sizeof(_T) * 8 - 1)) : bits_type(0)));
+        }
+      };
+      template <class _T, class _Bits>
+      struct FloatRadixKey
+      {
+        static constexpr bool enabled = true;
+        using bits_type = _Bits;
+        static auto to_bits(_T value) -> bits_type
+        {
+          // negative : flip all bits (reverses their order), positive : flip the sign bit
+          auto bits = bits_type{};
+          std::memcpy(&bits, &value, sizeof(bits));
+          const auto sign = static_cast <bits_type>(bits_type(1) << (sizeof(bits_type) * 8 - 1));
+          return (bits & sign) ? static_cast <bits_type>(~bits) : static_cast <bits_type>(bits | sign);
+        }
+      };
+      template <>
+      struct RadixKey <float> : public FloatRadixKey <float, std::uint32_t> {};
+      template <>
+      struct RadixKey <double> : public FloatRadixKey <double, std::uint64_t> {};
+
+      // Element and the key it is sorted by (key_of is called only once per element).
+      template <class _Key>
+      struct Keyed
+      {
+      public:
+        _Key key;
+        std::size_t index;
+      };
+
+      // Stable LSD radix sort by 8 bit digits of bits_of(item) (buffer : length scratch items).
+      // Each pass counts the digits per chunk and scatters every chunk to its own offsets, so chunks run in parallel.
+      // Passes whose digit is the same for every item are skipped.
+      template <class _Item, class _BitsOf>
+      inline auto radix_sort(_Item *data, _Item *buffer, std::size_t length, _BitsOf bits_of, std::size_t num_of_chunks) -> void
+      {
+        using bits_type = typename std::decay <decltype(bits_of(*data))>::type;
+        constexpr std::size_t RADIX = 256;
+        if (num_of_chunks == 0)
+        {
+          return;
+        }
+        auto counts = std::vector <std::size_t>(num_of_chunks * RADIX);
+        auto src = data;
+        auto dst = buffer;
+        for (std::size_t shift = 0; shift < sizeof(bits_type) * 8; shift += 8)
+        {
+          std::fill(counts.begin(), counts.end(), std::size_t(0));
+          execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, std::size_t begin, std::size_t end)
+          {
+            const auto histogram = counts.data() + chunk * RADIX;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+              ++histogram[(bits_of(src[i]) >> shift) & (RADIX - 1)];
+            }
+          });
+
+          // offsets : digit major, then chunk order (keeps the pass stable)
+          auto offset = std::size_t(0);
+          auto trivial = false;
+          for (std::size_t digit = 0; digit < RADIX; ++digit)
+          {
+            const auto first = offset;
+            for (std::size_t chunk = 0; chunk < num_of_chunks; ++chunk)
+            {
+              const auto count = counts[chunk * RADIX + digit];
+              counts[chunk * RADIX + digit] = offset;
+              offset += count;
+            }
+            trivial = trivial || offset - first == length;
+          }
+          if (trivial)
+          {
+            continue;
+          }
+
+          execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, std::size_t begin, std::size_t end)
+          {
+            const auto offsets = counts.data() + chunk * RADIX;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+              dst[offsets[(bits_of(src[i]) >> shift) & (RADIX - 1)]++] = std::move(src[i]);
+            }
+          });
+          std::swap(src, dst);
+        }
+        if (src != data)
+        {
+          execution::run_chunks(num_of_chunks, length, [&](std::size_t, std::size_t begin, std::size_t end)
+          {
+            std::move(src + begin, src + end, data + begin);
+          });
+        }
+      }
+
+      // Number of elements taken from lhs within the first rank elements of merge(lhs, rhs) (lhs wins ties).
+      template <class _T, class _Compare>
+      inline auto co_rank(const _T *lhs, std::size_t lhs_length, const _T *rhs, std::size_t rhs_length, std::size_t rank, _Compare &compare) -> std::size_t
+      {
+        auto low = rank > rhs_length ? rank - rhs_length : 0;
+        auto high = rank < lhs_length ? rank : lhs_length;
+        while (low < high)
+        {
+          const auto middle = low + (high - low) / 2;
+          if (compare(rhs[rank - middle - 1], lhs[middle]))
+          {
+            high = middle;
+          }
+          else
+          {
+            low = middle + 1;
+          }
+        }
+        return low;
+      }
+
+      // Merges neighbouring runs ([runs[2q], runs[2q + 1]) with [runs[2q + 1], runs[2q + 2])) from src into dst.
+      // Every chunk produces its own range of dst. Where the chunk boundaries fall inside a merge is found by co_rank
+      // for all boundaries first, as the merges move elements out of src.
+      template <class _T, class _Compare>
+      inline auto merge_runs(_T *src, _T *dst, const std::vector <std::size_t> &runs, std::size_t length, _Compare &compare, std::size_t num_of_chunks) -> void
+      {
+        // visits the merges overlapping [begin, end) : func(first, middle, last)
+        auto each_merge = [&runs](std::size_t begin, std::size_t end, auto &&func)
+        {
+          for (std::size_t run = 0; run + 1 < runs.size(); run += 2)
+          {
+            const auto first = runs[run];
+            const auto middle = runs[run + 1];
+            const auto last = run + 2 < runs.size() ? runs[run + 2] : middle;
+            if (first < end && begin < last)
+            {
+              func(first, middle, last);
+            }
+          }
+        };
+
+        auto splits = std::vector <std::size_t>(num_of_chunks + 1);
+        execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, std::size_t begin, std::size_t)
+        {
+          each_merge(begin, begin + 1, [&](std::size_t first, std::size_t middle, std::size_t last)
+          {
+            splits[chunk] = co_rank(src + first, middle - first, src + middle, last - middle, begin - first, compare);
+          });
+        });
+
+        execution::run_chunks(num_of_chunks, length, [&](std::size_t chunk, std::size_t begin, std::size_t end)
+        {
+          each_merge(begin, end, [&](std::size_t first, std::size_t middle, std::size_t last)
+          {
+            const auto rank_begin = begin > first ? begin - first : 0;
+            const auto rank_end = end < last ? end - first : last - first;
+            const auto lhs_begin = begin > first ? splits[chunk] : 0;
+            const auto lhs_end = end < last ? splits[chunk + 1] : middle - first;
+            const auto lhs = src + first;
+            const auto rhs = src + middle;
+            std::merge(std::make_move_iterator(lhs + lhs_begin), std::make_move_iterator(lhs + lhs_end),
+                       std::make_move_iterator(rhs + (rank_begin - lhs_begin)), std::make_move_iterator(rhs + (rank_end - lhs_end)),
+                       dst + first + rank_begin, compare);
+          });
+        });
+      }
+
+      // Sorts every chunk, then merges the sorted runs pairwise until one is left (stable when stable = true).
+      template <class _T, class _Compare>
+      inline auto merge_sort(_T *data, std::size_t length, _Compare &compare, bool stable, std::size_t num_of_chunks) -> void
+      {
+        if (num_of_chunks <= 1)
+        {
+          stable ? std::stable_sort(data, data + length, compare) : std::sort(data, data + length, compare);
+          return;
+        }
+        auto runs = std::vector <std::size_t>{};
+        for (std::size_t chunk = 0; chunk <= num_of_chunks; ++chunk)
+        {
+          runs.push_back(execution::chunk_begin(length, num_of_chunks, chunk));
+        }
+        execution::run_chunks(num_of_chunks, length, [&](std::size_t, std::size_t begin, std::size_t end)
+        {
+          stable ? std::stable_sort(data + begin, data + end, compare) : std::sort(data + begin, data + end, compare);
+        });
+
+        auto buffer = std::vector <_T>(std::make_move_iterator(data), std::make_move_iterator(data + length));
+        auto src = buffer.data();
+        auto dst = data;
+        while (runs.size() > 2)
+        {
+          merge_runs(src, dst, runs, length, compare, num_of_chunks);
+          auto merged = std::vector <std::size_t>{};
+          for (std::size_t run = 0; run + 1 < runs.size(); run += 2)
+          {
+            merged.push_back(runs[run]);
+          }
+          merged.push_back(length);
+          runs.swap(merged);
+          std::swap(src, dst);
+        }
+        if (src != data)
+        {
+          execution::run_chunks(num_of_chunks, length, [&](std::size_t, std::size_t begin, std::size_t end)
+          {
+            std::move(src + begin, src + end, data + begin);
+          });
+        }
+      }
+
+      // sort () : radix sort for integer / floating point values, merge sort by operator < otherwise
+      template <class _T>
+      inline auto sort_values(_T *data, std::size_t length, std::size_t num_of_chunks, std::true_type) -> void
+      {
+        if (length < RADIX_THRESHOLD)
+        {
+          std::sort(data, data + length);
+          return;
+        }
+        auto buffer = std::vector <_T>(length);
+        radix_sort(data, buffer.data(), length, [](_T value) { return RadixKey <_T>::to_bits(value); }, num_of_chunks);
+      }
+      template <class _T>
+      inline auto sort_values(_T *data, std::size_t length, std::size_t num_of_chunks, std::false_type) -> void
+      {
+        auto compare = [](const _T &lhs, const _T &rhs) { return lhs < rhs; };
+        merge_sort(data, length, compare, false, num_of_chunks);
+      }
+      template <class _T>
+      inline auto sort_values(_T *data, std::size_t length, std::size_t num_of_chunks) -> void
+      {
+        sort_values(data, length, num_of_chunks, std::integral_constant <bool, RadixKey <_T>::enabled>{});
+      }
+
+      // sort_by () : orders (key, index) pairs, by radix sort for integer / floating point keys
+      template <class _Key>
+      inline auto sort_keys(std::vector <Keyed <_Key>> &keys, bool, std::size_t num_of_chunks, std::true_type) -> void
+      {
+        using bits_type = typename RadixKey <_Key>::bits_type;
+        const auto length = keys.size();
+        auto items = std::vector <Keyed <bits_type>>(length);
+        auto buffer = std::vector <Keyed <bits_type>>(length);
+        execution::run_chunks(num_of_chunks, length, [&](std::size_t, std::size_t begin, std::size_t end)
+        {
+          for (std::size_t i = begin; i < end; ++i)
+          {
+            items[i] = Keyed <bits_type>{ RadixKey <_Key>::to_bits(keys[i].key), keys[i].index };
+          }
+        });
+        radix_sort(items.data(), buffer.data(), length, [](const Keyed <bits_type> &item) { return item.key; }, num_of_chunks);
+        execution::run_chunks(num_of_chunks, length, [&](std::size_t, std::size_t begin, std::size_t end)
+        {
+          for (std::size_t i = begin; i < end; ++i)
+          {
+            keys[i].index = items[i].index;
+          }
+        });
+      }
+      template <class _Key>
+      inline auto sort_keys(std::vector <Keyed <_Key>> &keys, bool stable, std::size_t num_of_chunks, std::false_type) -> void
+      {
+        auto compare = [](const Keyed <_Key> &lhs, const Keyed <_Key> &rhs) { return lhs.key < rhs.key; };
+        merge_sort(keys.data(), keys.size(), compare, stable, num_of_chunks);
+      }
+
+      // Computes key_of once per element, orders the keys and moves every element to its place.
+      template <class _T, class _KeyOf>
+      inline auto sort_by(_T *data, std::size_t length, _KeyOf &key_of, bool stable, std::size_t num_of_chunks) -> void
+      {
+        using key_type = typename std::decay <decltype(key_of(std::declval <const _T &>()))>::type;
+        constexpr bool radix = RadixKey <key_type>::enabled;
+        auto keys = std::vector <Keyed <key_type>>{};
+        keys.reserve(length);
+        for (std::size_t i = 0; i < length; ++i)
+        {
+          keys.push_back(Keyed <key_type>{ key_of(static_cast <const _T &>(data[i])), i });
+        }
+        if (radix && length >= RADIX_THRESHOLD)
+        {
+          sort_keys(keys, stable, num_of_chunks, std::integral_constant <bool, radix>{});
+        }
+        else
+        {
+          sort_keys(keys, stable, num_of_chunks, std::false_type{});
+        }
+
+        auto buffer = std::vector <_T>(std::make_move_iterator(data), std::make_move_iterator(data + length));
+        execution::run_chunks(num_of_chunks == 0 ? 1 : num_of_chunks, length, [&](std::size_t, std::size_t begin, std::size_t end)
+        {
+          for (std::size_t i = begin; i < end; ++i)
+          {
+            data[i] = std::move(buffer[keys[i].index]);
+          }
+        });
+      }
+    }
+  }
+}
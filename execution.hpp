@@ -0,0 +1,228 @@
+﻿#pragma once
+
+#include "index_range.hpp"
+#include "scheduler.hpp"
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace matsulib
+{
+  namespace execution
+  {
+    // How parallel_for over an IndexRange hands out indices.
+    enum class Schedule : int
+    {
+      // one contiguous chunk per thread
+      STATIC = 0,
+      // chunks of grain_size taken by whichever thread is free
+      DYNAMIC = 1,
+      // chunks shrinking with the remaining work, never below grain_size
+      GUIDED = 2
+    };
+
+    struct ParallelPolicy
+    {
+    public:
+      // minimum number of elements handed to one thread
+      std::size_t grain_size = 4096;
+      Schedule schedule = Schedule::STATIC;
+    };
+
+    constexpr ParallelPolicy par = {};
+  }
+
+  using execution::par;
+
+  namespace _detail
+  {
+    namespace execution
+    {
+      inline auto concurrency() -> std::size_t
+      {
+        return matsulib::execution::Scheduler::concurrency();
+      }
+
+      inline auto num_of_chunks(const matsulib::execution::ParallelPolicy &policy, std::size_t length) -> std::size_t
+      {
+        const auto grain_size = policy.grain_size == 0 ? 1 : policy.grain_size;
+        const auto max_chunks = (length + grain_size - 1) / grain_size;
+        const auto num_of_threads = concurrency();
+        return max_chunks < num_of_threads ? max_chunks : num_of_threads;
+      }
+
+      // chunk = [length * index / num_of_chunks, length * (index + 1) / num_of_chunks)
+      inline auto chunk_begin(std::size_t length, std::size_t num_of_chunks, std::size_t index) -> std::size_t
+      {
+        return static_cast <std::size_t>(static_cast <unsigned long long>(length) * index / num_of_chunks);
+      }
+
+      // Calls func(chunk_index, begin, end) for every chunk as tasks of the shared Scheduler.
+      // A single chunk runs on the calling thread without starting the scheduler. The first exception thrown by a chunk is rethrown.
+      template <class _Func>
+      inline auto run_chunks(std::size_t num_of_chunks, std::size_t length, _Func &&func) -> void
+      {
+        if (num_of_chunks <= 1)
+        {
+          if (num_of_chunks == 1)
+          {
+            func(std::size_t(0), std::size_t(0), length);
+          }
+          return;
+        }
+        matsulib::execution::Scheduler::instance().parallel_for(0, num_of_chunks, 1, [&](std::size_t first, std::size_t last)
+        {
+          for (auto index = first; index < last; ++index)
+          {
+            func(index, chunk_begin(length, num_of_chunks, index), chunk_begin(length, num_of_chunks, index + 1));
+          }
+        });
+      }
+    }
+  }
+}
+
+namespace matsulib
+{
+  // func(i) for every i in [begin, end) on the shared Scheduler, in pieces of at least policy.grain_size indices.
+  // Without a policy the range is cut into about 8 pieces per thread.
+  template <class _Func>
+  inline auto parallel_for(const execution::ParallelPolicy &policy, std::size_t begin, std::size_t end, _Func &&func) -> void
+  {
+    if (end <= begin)
+    {
+      return;
+    }
+    const auto grain_size = policy.grain_size == 0 ? 1 : policy.grain_size;
+    const auto run = [&func](std::size_t first, std::size_t last)
+    {
+      for (auto i = first; i < last; ++i)
+      {
+        func(i);
+      }
+    };
+    if (end - begin <= grain_size)
+    {
+      run(begin, end);
+      return;
+    }
+    execution::Scheduler::instance().parallel_for(begin, end, grain_size, run);
+  }
+  template <class _Func>
+  inline auto parallel_for(std::size_t begin, std::size_t end, _Func &&func) -> void
+  {
+    const auto length = end <= begin ? 0 : end - begin;
+    parallel_for(execution::ParallelPolicy{ length / (_detail::execution::concurrency() * 8) + 1 }, begin, end, std::forward <_Func>(func));
+  }
+
+  // func(i) for every i of range, handed out by policy.schedule in chunks of at least policy.grain_size indices.
+  template <class _Index, class _Func>
+  inline auto parallel_for(const execution::ParallelPolicy &policy, const IndexRange <_Index> &range, _Func &&func) -> void
+  {
+    const auto grain_size = policy.grain_size == 0 ? 1 : policy.grain_size;
+    const auto length = range.size();
+    const auto run = [&func](const IndexRange <_Index> &chunk)
+    {
+      for (const auto i : chunk)
+      {
+        func(i);
+      }
+    };
+    const auto num_of_threads = _detail::execution::concurrency();
+    if (length <= grain_size || num_of_threads <= 1)
+    {
+      run(range);
+      return;
+    }
+    auto &scheduler = execution::Scheduler::instance();
+    if (policy.schedule == execution::Schedule::STATIC)
+    {
+      const auto chunks = range.split(num_of_threads, grain_size);
+      scheduler.parallel_for(0, chunks.size(), 1, [&](std::size_t first, std::size_t last)
+      {
+        for (auto chunk = first; chunk < last; ++chunk)
+        {
+          run(chunks[chunk]);
+        }
+      });
+      return;
+    }
+    // one claiming loop per thread ; next is the first index nobody has taken yet
+    const auto max_workers = (length + grain_size - 1) / grain_size;
+    const auto num_of_workers = num_of_threads < max_workers ? num_of_threads : max_workers;
+    const auto guided = policy.schedule == execution::Schedule::GUIDED;
+    std::atomic <std::size_t> next{ 0 };
+    scheduler.parallel_for(0, num_of_workers, 1, [&](std::size_t first, std::size_t last)
+    {
+      for (auto worker = first; worker < last; ++worker)
+      {
+        for (;;)
+        {
+          auto begin = next.load();
+          auto chunk_size = grain_size;
+          if (guided)
+          {
+            do
+            {
+              const auto remaining = begin < length ? length - begin : 0;
+              chunk_size = remaining / (2 * num_of_workers);
+              chunk_size = chunk_size < grain_size ? grain_size : chunk_size;
+            } while (begin < length && !next.compare_exchange_weak(begin, begin + chunk_size));
+          }
+          else
+          {
+            begin = next.fetch_add(chunk_size);
+          }
+          if (begin >= length)
+          {
+            break;
+          }
+          run(range.subrange(begin, begin + chunk_size));
+        }
+      }
+    });
+  }
+  // dynamic schedule, about 8 chunks per thread
+  template <class _Index, class _Func>
+  inline auto parallel_for(const IndexRange <_Index> &range, _Func &&func) -> void
+  {
+    parallel_for(execution::ParallelPolicy{ range.size() / (_detail::execution::concurrency() * 8) + 1, execution::Schedule::DYNAMIC }, range, std::forward <_Func>(func));
+  }
+
+  // func(x, y, ...) for every point of range, in slices of the outermost dimension (rows of a 2D range) holding at least policy.grain_size points.
+  template <class _Index, std::size_t _N, class _Func>
+  inline auto parallel_for(const execution::ParallelPolicy &policy, const MultiIndexRange <_Index, _N> &range, _Func &&func) -> void
+  {
+    const auto num_of_slices = range.extent(_N - 1);
+    if (range.empty())
+    {
+      return;
+    }
+    const auto slice_size = range.size() / num_of_slices;
+    parallel_for(execution::ParallelPolicy{ policy.grain_size / slice_size + 1 }, 0, num_of_slices, [&range, &func](std::size_t slice)
+    {
+      range.subrange(slice, slice + 1).each(func);
+    });
+  }
+  template <class _Index, std::size_t _N, class _Func>
+  inline auto parallel_for(const MultiIndexRange <_Index, _N> &range, _Func &&func) -> void
+  {
+    parallel_for(execution::ParallelPolicy{ range.size() / (_detail::execution::concurrency() * 8) + 1 }, range, std::forward <_Func>(func));
+  }
+  // func(tile) for every tile (a MultiIndexRange), one task per tile.
+  template <class _Index, std::size_t _N, class _Func>
+  inline auto parallel_for(const TiledIndexRange <_Index, _N> &tiles, _Func &&func) -> void
+  {
+    parallel_for(execution::ParallelPolicy{ 1 }, 0, tiles.size(), [&tiles, &func](std::size_t position)
+    {
+      func(tiles[position]);
+    });
+  }
+
+  // Runs every func, possibly at the same time, on the shared Scheduler.
+  template <class ..._Funcs>
+  inline auto parallel_invoke(_Funcs &&...funcs) -> void
+  {
+    execution::Scheduler::instance().parallel_invoke(std::forward <_Funcs>(funcs)...);
+  }
+}
@@ -0,0 +1,229 @@
+﻿#pragma once
+
+#include "array.hpp"
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace matsulib
+{
+  namespace _detail
+  {
+    namespace flat_hash_map
+    {
+      // Spreads the bits of std::hash results (identity for integers on most implementations) over the whole word.
+      inline auto mix(std::size_t hash) -> std::size_t
+      {
+        auto bits = static_cast <unsigned long long>(hash);
+        bits ^= bits >> 33;
+        bits *= 0xff51afd7ed558ccdULL;
+        bits ^= bits >> 33;
+        return static_cast <std::size_t>(bits);
+      }
+    }
+  }
+}
+
+// Open addressing hash map : the entries are kept contiguously in insertion order and a power-of-two slot table
+// (hash, entry index) is probed linearly, so lookups touch one slot line and iteration is a plain array walk.
+// There is no erase. Keys must not be modified through iterators.
+template <class _Key, class _Value, class _Hash, class _KeyEqual>
+class matsulib::FlatHashMap
+{
+public:
+  using key_type = _Key;
+  using mapped_type = _Value;
+  using value_type = std::pair <_Key, _Value>;
+  using size_type = std::size_t;
+  using hasher = _Hash;
+  using key_equal = _KeyEqual;
+  using iterator = typename std::vector <value_type>::iterator;
+  using const_iterator = typename std::vector <value_type>::const_iterator;
+
+protected:
+  struct Slot
+  {
+  public:
+    std::size_t hash;
+    size_type index;
+  };
+  static constexpr size_type EMPTY = std::numeric_limits <size_type>::max();
+  static constexpr size_type MIN_SLOTS = 8;
+
+  std::vector <value_type> _entries;
+  std::vector <Slot> _slots;
+  _Hash _hash;
+  _KeyEqual _equal;
+
+public:
+  FlatHashMap() = default;
+  explicit FlatHashMap(size_type capacity, const _Hash &hash = _Hash{}, const _KeyEqual &equal = _KeyEqual{}) : _hash{ hash }, _equal{ equal }
+  {
+    reserve(capacity);
+  }
+
+public:
+  auto size() const -> size_type { return _entries.size(); }
+  auto empty() const -> bool { return _entries.empty(); }
+
+  auto begin() -> iterator { return _entries.begin(); }
+  auto begin() const -> const_iterator { return _entries.begin(); }
+  auto end() -> iterator { return _entries.end(); }
+  auto end() const -> const_iterator { return _entries.end(); }
+
+  // keeps the load factor at most 1/2 up to capacity entries
+  auto reserve(size_type capacity) -> void
+  {
+    _entries.reserve(capacity);
+    auto num_of_slots = _slots.empty() ? MIN_SLOTS : _slots.size();
+    while (num_of_slots < capacity * 2)
+    {
+      num_of_slots *= 2;
+    }
+    if (num_of_slots != _slots.size())
+    {
+      rehash(num_of_slots);
+    }
+  }
+  auto clear() -> void
+  {
+    _entries.clear();
+    for (auto &slot : _slots)
+    {
+      slot.index = EMPTY;
+    }
+  }
+
+  auto find(const _Key &key) -> iterator
+  {
+    const auto index = find_index(key);
+    return index == EMPTY ? end() : begin() + index;
+  }
+  auto find(const _Key &key) const -> const_iterator
+  {
+    const auto index = find_index(key);
+    return index == EMPTY ? end() : begin() + index;
+  }
+  auto count(const _Key &key) const -> size_type { return find_index(key) == EMPTY ? 0 : 1; }
+  auto contains(const _Key &key) const -> bool { return find_index(key) != EMPTY; }
+
+  auto at(const _Key &key) -> _Value & { return const_cast <_Value &>(static_cast <const FlatHashMap &>(*this).at(key)); }
+  auto at(const _Key &key) const -> const _Value &
+  {
+    const auto index = find_index(key);
+    if (index == EMPTY)
+    {
+      throw std::out_of_range{ "matsulib::FlatHashMap::at() : Key Not Found!!" };
+    }
+    return _entries[index].second;
+  }
+  auto operator [](const _Key &key) -> _Value & { return try_emplace(key).first->second; }
+  auto operator [](_Key &&key) -> _Value & { return try_emplace(std::move(key)).first->second; }
+
+  // Inserts (key, _Value(args...)) unless key is present; key and args are left untouched then.
+  template <class ..._Args>
+  auto try_emplace(const _Key &key, _Args &&...args) -> std::pair <iterator, bool> { return emplace_key(key, std::forward <_Args>(args)...); }
+  template <class ..._Args>
+  auto try_emplace(_Key &&key, _Args &&...args) -> std::pair <iterator, bool> { return emplace_key(std::move(key), std::forward <_Args>(args)...); }
+
+  // func(key, value) in insertion order
+  template <class _Func>
+  auto each(_Func &&func) const -> const FlatHashMap &
+  {
+    for (const auto &entry : _entries)
+    {
+      func(entry.first, entry.second);
+    }
+    return *this;
+  }
+  auto keys() const -> Array <_Key>
+  {
+    auto dst_array = Array <_Key>{};
+    dst_array.reserve(size());
+    for (const auto &entry : _entries)
+    {
+      dst_array.push_back(entry.first);
+    }
+    return dst_array;
+  }
+  auto values() const -> Array <_Value>
+  {
+    auto dst_array = Array <_Value>{};
+    dst_array.reserve(size());
+    for (const auto &entry : _entries)
+    {
+      dst_array.push_back(entry.second);
+    }
+    return dst_array;
+  }
+
+protected:
+  auto find_index(const _Key &key) const -> size_type
+  {
+    if (_slots.empty())
+    {
+      return EMPTY;
+    }
+    const auto hash = _detail::flat_hash_map::mix(_hash(key));
+    const auto mask = _slots.size() - 1;
+    for (auto position = hash & mask; ; position = (position + 1) & mask)
+    {
+      const auto &slot = _slots[position];
+      if (slot.index == EMPTY)
+      {
+        return EMPTY;
+      }
+      if (slot.hash == hash && _equal(_entries[slot.index].first, key))
+      {
+        return slot.index;
+      }
+    }
+  }
+
+  template <class _K, class ..._Args>
+  auto emplace_key(_K &&key, _Args &&...args) -> std::pair <iterator, bool>
+  {
+    if ((_entries.size() + 1) * 2 > _slots.size())
+    {
+      rehash(_slots.empty() ? MIN_SLOTS : _slots.size() * 2);
+    }
+    const auto hash = _detail::flat_hash_map::mix(_hash(key));
+    const auto mask = _slots.size() - 1;
+    auto position = hash & mask;
+    for (; _slots[position].index != EMPTY; position = (position + 1) & mask)
+    {
+      const auto &slot = _slots[position];
+      if (slot.hash == hash && _equal(_entries[slot.index].first, key))
+      {
+        return { begin() + slot.index, false };
+      }
+    }
+    _entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::forward <_K>(key)), std::forward_as_tuple(std::forward <_Args>(args)...));
+    _slots[position] = Slot{ hash, _entries.size() - 1 };
+    return { end() - 1, true };
+  }
+
+  // rebuilds the slot table from the cached hashes (keys are not hashed again)
+  auto rehash(size_type num_of_slots) -> void
+  {
+    auto slots = std::vector <Slot>(num_of_slots, Slot{ 0, EMPTY });
+    const auto mask = num_of_slots - 1;
+    for (const auto &slot : _slots)
+    {
+      if (slot.index != EMPTY)
+      {
+        auto position = slot.hash & mask;
+        while (slots[position].index != EMPTY)
+        {
+          position = (position + 1) & mask;
+        }
+        slots[position] = slot;
+      }
+    }
+    _slots.swap(slots);
+  }
+};
@@ -2,6 +2,7 @@
 
 #define _CRT_SECURE_NO_WARNINGS
 #include <cmath>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -23,6 +24,7 @@ namespace matsulib { namespace image { namespace _detail
 #include "details/image/stb_image_write.h"
 }}}
 
+#include "execution.hpp"
 #include <vector>
 #include <string>
 #include <tuple>
@@ -39,6 +41,18 @@ namespace matsulib
     std::vector <unsigned char> pixels = {};
   };
 
+  // Image stored in blocks of 32 x 32 pixels (blocks row by row, Z-order inside a block), padded to whole blocks.
+  // Pixels that are close in 2D stay close in memory, so neighbourhood kernels touch fewer cache lines and pages.
+  // Pixel (x, y) starts at pixels [image::morton_index(img, x, y) * channel] ; see image::to_morton / image::to_row_major.
+  struct MortonImage final
+  {
+  public:
+    int width = 0;
+    int height = 0;
+    int channel = 0;
+    std::vector <unsigned char> pixels = {};
+  };
+
   namespace image
   {
     enum class Component : int
@@ -78,6 +92,30 @@ namespace matsulib
       return dst_imgs;
     }
 
+    // Pixels are split between the threads of the shared Scheduler (policy.grain_size pixels at least per task).
+    inline auto parse(const execution::ParallelPolicy &policy, const matsulib::Image &src_img) -> std::vector <matsulib::Image>
+    {
+      auto src_img_size = src_img.pixels.size();
+      auto num_of_channel = src_img.channel;
+      std::vector <matsulib::Image> dst_imgs(num_of_channel);
+      auto dst_img_size = num_of_channel == 0 ? 0 : src_img_size / num_of_channel;
+      for (auto &dst_img : dst_imgs)
+      {
+        dst_img.channel = 1;
+        dst_img.width = src_img.width;
+        dst_img.height = src_img.height;
+        dst_img.pixels.resize(dst_img_size);
+      }
+      matsulib::parallel_for(policy, 0, dst_img_size, [&](std::size_t i)
+      {
+        for (decltype(num_of_channel) channel = 0; channel < num_of_channel; channel++)
+        {
+          dst_imgs[channel].pixels[i] = src_img.pixels[i * num_of_channel + channel];
+        }
+      });
+      return dst_imgs;
+    }
+
     namespace _detail
     {
       inline auto merge_impl(matsulib::Image &dst, int channel_index, const matsulib::Image &src) -> void
@@ -128,6 +166,33 @@ namespace matsulib
       return dst_img;
     }
 
+    // Channels are merged on the shared Scheduler, each channel split into tasks of policy.grain_size pixels at least.
+    inline auto merge(const execution::ParallelPolicy &policy, const std::vector <matsulib::Image> &src_imgs) -> matsulib::Image
+    {
+      matsulib::Image dst_img;
+      if (src_imgs.size() == 0)
+      {
+        return dst_img;
+      }
+      auto num_of_channel = src_imgs.size();
+      dst_img.channel = static_cast <decltype(dst_img.channel)>(num_of_channel);
+      dst_img.width = src_imgs[0].width;
+      dst_img.height = src_imgs[0].height;
+      dst_img.pixels.resize(src_imgs[0].pixels.size() * dst_img.channel);
+      auto img_size = src_imgs[0].pixels.size();
+      matsulib::parallel_for(policy, 0, img_size, [&](std::size_t i)
+      {
+        for (decltype(num_of_channel) channel = 0; channel < num_of_channel; channel++)
+        {
+          if (i < src_imgs[channel].pixels.size())
+          {
+            dst_img.pixels[i * num_of_channel + channel] = src_imgs[channel].pixels[i];
+          }
+        }
+      });
+      return dst_img;
+    }
+
     auto write(const std::string &filename, const matsulib::Image &src, const Format fmt = Format::NOT_SPECIFIED) -> void
     {
       std::function <int(const char *, int, int, int, const void *)> write;
@@ -165,6 +230,80 @@ namespace matsulib
       return dst;
     }
 
+    // Rows are copied on the shared Scheduler, policy.grain_size pixels (whole rows) at least per task.
+    inline auto rectangle(const execution::ParallelPolicy &policy, const matsulib::Image &src, decltype(matsulib::Image::width) beg_x, decltype(matsulib::Image::height) beg_y, decltype(matsulib::Image::width) width, decltype(matsulib::Image::height) height) -> matsulib::Image
+    {
+      matsulib::Image dst;
+      dst.channel = src.channel;
+      dst.width = width;
+      dst.height = height;
+      dst.pixels.resize(width * height * dst.channel);
+      const auto rows_per_task = width <= 0 ? policy.grain_size : policy.grain_size / static_cast <std::size_t>(width) + 1;
+      matsulib::parallel_for(execution::ParallelPolicy{ rows_per_task }, 0, static_cast <std::size_t>(height), [&](std::size_t row)
+      {
+        const auto y = static_cast <decltype(height)>(row);
+        const auto dst_row = dst.pixels.data() + static_cast <std::size_t>(y * width) * dst.channel;
+        const auto src_row = src.pixels.data() + static_cast <std::size_t>((y + beg_y) * src.width + beg_x) * src.channel;
+        std::memcpy(dst_row, src_row, static_cast <std::size_t>(width) * dst.channel);
+      });
+      return dst;
+    }
+
+    // pixel coordinates (x, y) of img, x varying fastest.
+    // pixel_range(img).tiled(64, 64) gives cache-sized blocks for parallel_for.
+    inline auto pixel_range(const matsulib::Image &img) -> IndexRange2d <int>
+    {
+      return index_range_2d(img.width, img.height);
+    }
+
+    // MortonImage blocks are (1 << MORTON_BLOCK_BITS) pixels square
+    constexpr int MORTON_BLOCK_BITS = 5;
+
+    inline auto morton_index(const matsulib::MortonImage &img, int x, int y) -> std::size_t
+    {
+      const auto mask = (1 << MORTON_BLOCK_BITS) - 1;
+      const auto blocks_x = static_cast <std::size_t>((img.width + mask) >> MORTON_BLOCK_BITS);
+      const auto block = static_cast <std::size_t>(y >> MORTON_BLOCK_BITS) * blocks_x + static_cast <std::size_t>(x >> MORTON_BLOCK_BITS);
+      return (block << (2 * MORTON_BLOCK_BITS)) | static_cast <std::size_t>(matsulib::_detail::index_range::morton_encode(static_cast <std::uint32_t>(x & mask), static_cast <std::uint32_t>(y & mask)));
+    }
+
+    inline auto to_morton(const matsulib::Image &src) -> matsulib::MortonImage
+    {
+      matsulib::MortonImage dst;
+      dst.width = src.width;
+      dst.height = src.height;
+      dst.channel = src.channel;
+      const auto mask = (1 << MORTON_BLOCK_BITS) - 1;
+      dst.pixels.resize(static_cast <std::size_t>((src.width + mask) & ~mask) * static_cast <std::size_t>((src.height + mask) & ~mask) * src.channel);
+      const auto channel = static_cast <std::size_t>(src.channel);
+      for (decltype(src.height) y = 0; y < src.height; y++)
+      {
+        for (decltype(src.width) x = 0; x < src.width; x++)
+        {
+          std::memcpy(dst.pixels.data() + morton_index(dst, x, y) * channel, src.pixels.data() + (static_cast <std::size_t>(y) * src.width + x) * channel, channel);
+        }
+      }
+      return dst;
+    }
+
+    inline auto to_row_major(const matsulib::MortonImage &src) -> matsulib::Image
+    {
+      matsulib::Image dst;
+      dst.width = src.width;
+      dst.height = src.height;
+      dst.channel = src.channel;
+      dst.pixels.resize(static_cast <std::size_t>(src.width) * src.height * src.channel);
+      const auto channel = static_cast <std::size_t>(src.channel);
+      for (decltype(src.height) y = 0; y < src.height; y++)
+      {
+        for (decltype(src.width) x = 0; x < src.width; x++)
+        {
+          std::memcpy(dst.pixels.data() + (static_cast <std::size_t>(y) * src.width + x) * channel, src.pixels.data() + morton_index(src, x, y) * channel, channel);
+        }
+      }
+      return dst;
+    }
+
     auto read(const std::string &filename, const Component comp = Component::NOT_SPECIFIED) -> matsulib::Image
     {
       int w, h, cmp;
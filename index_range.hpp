@@ -1,11 +1,35 @@
 ﻿#pragma once
 
 #include "has_iterator.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
+// pdep / pext interleave Morton codes when the target is built with BMI2 (-mbmi2, -march=haswell, /arch:AVX2)
+#if (defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))) && (defined(__x86_64__) || defined(_M_X64))
+#define MATSULIB_INDEX_RANGE_BMI2 1
+#include <immintrin.h>
+#endif
 
 namespace matsulib
 {
   template <class> class IndexRange;
+  template <class> class IndexIterator;
+  template <class _Index, std::size_t _N> class MultiIndexRange;
+  template <class _Index, std::size_t _N> class MultiIndexIterator;
+  template <class _Index, std::size_t _N> class TiledIndexRange;
+  template <class _Index, std::size_t _N> class TiledIndexIterator;
+  template <class _Index> using IndexRange2d = MultiIndexRange <_Index, 2>;
+  template <class _Index> using IndexRange3d = MultiIndexRange <_Index, 3>;
+  template <class _Index, class _Curve> class CurveIndexRange;
+  template <class _Index, class _Curve> class CurveIndexIterator;
+  template <std::size_t _N, class _Index> class SimdIndexRange;
+  template <std::size_t _N, class _Index> class SimdIndexIterator;
 
   namespace _detail
   {
@@ -22,6 +46,153 @@ namespace matsulib
         template <class _Index>
         static auto calc(_Index range) -> _Index { return range; }
       };
+
+      // Morton (Z-order) code : bits of x at the even positions, bits of y at the odd positions.
+      inline auto morton_encode(std::uint32_t x, std::uint32_t y) -> std::uint64_t
+      {
+#if defined(MATSULIB_INDEX_RANGE_BMI2)
+        return _pdep_u64(x, 0x5555555555555555ull) | _pdep_u64(y, 0xAAAAAAAAAAAAAAAAull);
+#else
+        const auto spread = [](std::uint64_t value)
+        {
+          value = (value | value << 16) & 0x0000FFFF0000FFFFull;
+          value = (value | value << 8) & 0x00FF00FF00FF00FFull;
+          value = (value | value << 4) & 0x0F0F0F0F0F0F0F0Full;
+          value = (value | value << 2) & 0x3333333333333333ull;
+          return (value | value << 1) & 0x5555555555555555ull;
+        };
+        return spread(x) | spread(y) << 1;
+#endif
+      }
+      inline auto morton_decode(std::uint64_t code) -> std::array <std::uint32_t, 2>
+      {
+#if defined(MATSULIB_INDEX_RANGE_BMI2)
+        return { { static_cast <std::uint32_t>(_pext_u64(code, 0x5555555555555555ull)), static_cast <std::uint32_t>(_pext_u64(code, 0xAAAAAAAAAAAAAAAAull)) } };
+#else
+        const auto compact = [](std::uint64_t value)
+        {
+          value &= 0x5555555555555555ull;
+          value = (value | value >> 1) & 0x3333333333333333ull;
+          value = (value | value >> 2) & 0x0F0F0F0F0F0F0F0Full;
+          value = (value | value >> 4) & 0x00FF00FF00FF00FFull;
+          value = (value | value >> 8) & 0x0000FFFF0000FFFFull;
+          return static_cast <std::uint32_t>(value | value >> 16);
+        };
+        return { { compact(code), compact(code >> 1) } };
+#endif
+      }
+
+      // A curve visits the 4 quadrants of a square in the order given by quadrant(state, digit, a, b) -> next state,
+      // (a, b) being the quadrant (0 or 1 along x and y) of the digit-th visit and next state the orientation inside it.
+      struct MortonCurve
+      {
+      public:
+        static auto quadrant(unsigned state, unsigned digit, std::uint32_t &a, std::uint32_t &b) -> unsigned
+        {
+          a = digit & 1;
+          b = digit >> 1;
+          return state;
+        }
+        static auto decode(std::uint64_t code, unsigned) -> std::array <std::uint32_t, 2> { return morton_decode(code); }
+      };
+      // Hilbert curve over a 2^bits x 2^bits square : consecutive codes are always neighbouring points.
+      // state = (swap << 1) | complement : orientation of the curve inside the current square.
+      struct HilbertCurve
+      {
+      public:
+        static auto quadrant(unsigned state, unsigned digit, std::uint32_t &a, std::uint32_t &b) -> unsigned
+        {
+          // quadrants (0, 0), (0, 1), (1, 1), (1, 0) ; the first turns by a swap, the last by a swap and a complement
+          const auto rx = std::uint32_t(digit >> 1);
+          const auto ry = std::uint32_t((digit ^ (digit >> 1)) & 1);
+          const auto complement = state & 1;
+          a = ((state & 2) != 0 ? ry : rx) ^ complement;
+          b = ((state & 2) != 0 ? rx : ry) ^ complement;
+          return state ^ (digit == 0 ? 2u : digit == 3 ? 3u : 0u);
+        }
+        static auto decode(std::uint64_t code, unsigned bits) -> std::array <std::uint32_t, 2>
+        {
+          auto x = std::uint32_t(0);
+          auto y = std::uint32_t(0);
+          auto state = 0u;
+          for (auto level = bits; level-- > 0;)
+          {
+            auto a = std::uint32_t(0);
+            auto b = std::uint32_t(0);
+            state = quadrant(state, static_cast <unsigned>(code >> (2 * level)) & 3, a, b);
+            x |= a << level;
+            y |= b << level;
+          }
+          return { { x, y } };
+        }
+      };
+
+      // func(x, y) for the points of the 2^level square at (x, y) in curve order, clipped to [0, width) x [0, height).
+      // Squares whose first corner is outside are skipped whole ; the last level is unrolled.
+      template <class _Curve, class _Func>
+      inline auto curve_visit(unsigned level, std::uint32_t x, std::uint32_t y, unsigned state, std::uint64_t width, std::uint64_t height, _Func &func) -> void
+      {
+        if (x >= width || y >= height)
+        {
+          return;
+        }
+        if (level == 0)
+        {
+          func(x, y);
+          return;
+        }
+        auto a = std::uint32_t(0);
+        auto b = std::uint32_t(0);
+        if (level == 1)
+        {
+          for (unsigned digit = 0; digit < 4; ++digit)
+          {
+            _Curve::quadrant(state, digit, a, b);
+            if (x + a < width && y + b < height)
+            {
+              func(x + a, y + b);
+            }
+          }
+          return;
+        }
+        const auto half = std::uint32_t(1) << (level - 1);
+        for (unsigned digit = 0; digit < 4; ++digit)
+        {
+          const auto next = _Curve::quadrant(state, digit, a, b);
+          curve_visit <_Curve>(level - 1, x + a * half, y + b * half, next, width, height, func);
+        }
+      }
+
+      // smallest bits with (1 << bits) >= length
+      inline auto curve_bits(std::uint64_t length) -> unsigned
+      {
+        auto bits = 0u;
+        for (; (std::uint64_t(1) << bits) < length; ++bits) {}
+        return bits;
+      }
+      // First code >= code whose point lies in [0, width) x [0, height) (or the end code 4^bits).
+      // An aligned run of 4^level codes covers an aligned square, so whole squares outside the box are skipped at once.
+      template <class _Curve>
+      inline auto curve_seek(std::uint64_t code, unsigned bits, std::uint64_t width, std::uint64_t height, std::array <std::uint32_t, 2> &point) -> std::uint64_t
+      {
+        const auto end = std::uint64_t(1) << (2 * bits);
+        while (code < end)
+        {
+          point = _Curve::decode(code, bits);
+          if (point[0] < width && point[1] < height)
+          {
+            return code;
+          }
+          auto level = 0u;
+          while (level < bits && (code & ((std::uint64_t(1) << (2 * (level + 1))) - 1)) == 0
+            && ((point[0] >> (level + 1) << (level + 1)) >= width || (point[1] >> (level + 1) << (level + 1)) >= height))
+          {
+            ++level;
+          }
+          code += std::uint64_t(1) << (2 * level);
+        }
+        return end;
+      }
     }
   }
 
@@ -37,20 +208,122 @@ namespace matsulib
     auto range_value = _detail::index_range::Range <typename has_iterator <_T>::type>::calc(range);
     return IndexRange <decltype(range_value)>{range_value};
   }
+
+  // points (x, y) of [0, width) x [0, height), x varying fastest
+  template <class _T>
+  auto index_range_2d(const _T &width, const _T &height)
+  {
+    return IndexRange2d <_T>{ { { _T{}, _T{} } }, { { width, height } } };
+  }
+  template <class _T>
+  auto index_range_2d(const IndexRange <_T> &x_range, const IndexRange <_T> &y_range)
+  {
+    return IndexRange2d <_T>{ { { x_range.front(), y_range.front() } }, { { x_range[x_range.size()], y_range[y_range.size()] } } };
+  }
+  // points (x, y, z) of [0, width) x [0, height) x [0, depth), x varying fastest
+  template <class _T>
+  auto index_range_3d(const _T &width, const _T &height, const _T &depth)
+  {
+    return IndexRange3d <_T>{ { { _T{}, _T{}, _T{} } }, { { width, height, depth } } };
+  }
+  template <class _T>
+  auto index_range_3d(const IndexRange <_T> &x_range, const IndexRange <_T> &y_range, const IndexRange <_T> &z_range)
+  {
+    return IndexRange3d <_T>{ { { x_range.front(), y_range.front(), z_range.front() } }, { { x_range[x_range.size()], y_range[y_range.size()], z_range[z_range.size()] } } };
+  }
+
+  // [begin, end) as blocks of _N indices plus a scalar remainder
+  template <std::size_t _N, class _T>
+  auto simd_range(const _T &begin, const _T &end)
+  {
+    return SimdIndexRange <_N, _T>{ begin, end };
+  }
+  template <std::size_t _N, class _T>
+  auto simd_range(const _T &range)
+  {
+    return SimdIndexRange <_N, _T>{ _T{}, range };
+  }
+  template <std::size_t _N, class _T>
+  auto batched(const IndexRange <_T> &range)
+  {
+    return SimdIndexRange <_N, _T>{ range.front(), range[range.size()] };
+  }
+
+  // points (x, y) of [0, width) x [0, height) in Z-order (Morton order)
+  template <class _T>
+  auto morton_range(const _T &width, const _T &height)
+  {
+    return CurveIndexRange <_T, _detail::index_range::MortonCurve>{ width, height };
+  }
+  // points (x, y) of [0, width) x [0, height) along a Hilbert curve
+  template <class _T>
+  auto hilbert_range(const _T &width, const _T &height)
+  {
+    return CurveIndexRange <_T, _detail::index_range::HilbertCurve>{ width, height };
+  }
 }
 
+// Random access iterator over the values of an IndexRange.
+// It only holds the current index, so a loop over an IndexRange compiles to a plain counted loop.
+template <class _Index>
+class matsulib::IndexIterator
+{
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = _Index;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const _Index *;
+  using reference = _Index;
+
+protected:
+  _Index _index;
+
+public:
+  IndexIterator() : _index{} {}
+  explicit IndexIterator(_Index index) : _index{ index } {}
+
+public:
+  auto operator *() const -> _Index { return _index; }
+  auto operator [](difference_type offset) const -> _Index { return static_cast <_Index>(_index + offset); }
+
+  auto operator ++() -> IndexIterator & { ++_index; return *this; }
+  auto operator ++(int) -> IndexIterator { auto previous = *this; ++_index; return previous; }
+  auto operator --() -> IndexIterator & { --_index; return *this; }
+  auto operator --(int) -> IndexIterator { auto previous = *this; --_index; return previous; }
+  auto operator +=(difference_type offset) -> IndexIterator & { _index = static_cast <_Index>(_index + offset); return *this; }
+  auto operator -=(difference_type offset) -> IndexIterator & { _index = static_cast <_Index>(_index - offset); return *this; }
+  auto operator +(difference_type offset) const -> IndexIterator { return IndexIterator{ static_cast <_Index>(_index + offset) }; }
+  auto operator -(difference_type offset) const -> IndexIterator { return IndexIterator{ static_cast <_Index>(_index - offset) }; }
+  auto operator -(const IndexIterator &other) const -> difference_type { return static_cast <difference_type>(_index - other._index); }
+  friend auto operator +(difference_type offset, const IndexIterator &iterator) -> IndexIterator { return iterator + offset; }
+
+  auto operator ==(const IndexIterator &other) const -> bool { return _index == other._index; }
+  auto operator !=(const IndexIterator &other) const -> bool { return _index != other._index; }
+  auto operator <(const IndexIterator &other) const -> bool { return _index < other._index; }
+  auto operator >(const IndexIterator &other) const -> bool { return _index > other._index; }
+  auto operator <=(const IndexIterator &other) const -> bool { return _index <= other._index; }
+  auto operator >=(const IndexIterator &other) const -> bool { return _index >= other._index; }
+};
+
+// Half-open range of indices [begin, end). An end below begin is clamped, so the range is empty.
 template <class _Index>
 class matsulib::IndexRange
 {
+public:
+  using value_type = _Index;
+  using size_type = std::size_t;
+  using iterator = IndexIterator <_Index>;
+  using const_iterator = iterator;
+
 protected:
+  _Index _begin;
   _Index _end;
-  _Index _index;
 
 public:
   // range = [begin, ..., end)
-  IndexRange(_Index begin, _Index end) : _end{ end }, _index{ begin } {}
+  IndexRange(_Index begin, _Index end) : _begin{ begin }, _end{ end < begin ? begin : end } {}
   // range = [0, ..., range)
-  explicit IndexRange(_Index range) : _end{ range }, _index { 0 } {}
+  explicit IndexRange(_Index range) : IndexRange{ _Index{}, range } {}
 
 public:
   IndexRange() = delete;
@@ -60,10 +333,494 @@ public:
   IndexRange &operator =(IndexRange &&) = default;
 
 public:
-  auto operator *() -> _Index { return _index; }
-  auto operator !=(IndexRange &) -> bool { return _index < _end; }
-  auto operator ++() -> void { ++_index; }
+  auto begin() const -> iterator { return iterator{ _begin }; }
+  auto end() const -> iterator { return iterator{ _end }; }
+
+  auto size() const -> size_type { return static_cast <size_type>(_end - _begin); }
+  auto empty() const -> bool { return _begin == _end; }
+  auto front() const -> _Index { return _begin; }
+  auto back() const -> _Index { return static_cast <_Index>(_end - 1); }
+  auto operator [](size_type position) const -> _Index { return static_cast <_Index>(_begin + position); }
+  auto at(size_type position) const -> _Index
+  {
+    if (position >= size())
+    {
+      throw std::out_of_range{ "matsulib::IndexRange::at() : Out Of Range!!" };
+    }
+    return (*this)[position];
+  }
+
+  // indices at positions [first, last) of this range (positions past the end are clamped)
+  auto subrange(size_type first, size_type last) const -> IndexRange
+  {
+    const auto length = size();
+    last = last < length ? last : length;
+    first = first < last ? first : last;
+    return IndexRange{ (*this)[first], (*this)[last] };
+  }
+  // [begin, begin + position) and [begin + position, end)
+  auto split_at(size_type position) const -> std::pair <IndexRange, IndexRange>
+  {
+    return std::make_pair(subrange(0, position), subrange(position, size()));
+  }
+  // halves (the second one takes the odd index)
+  auto split() const -> std::pair <IndexRange, IndexRange> { return split_at(size() / 2); }
+  // true when both halves of split() hold at least grain_size indices
+  auto is_divisible(size_type grain_size) const -> bool { return size() >= 2 * (grain_size == 0 ? 1 : grain_size); }
+  // At most num_of_chunks contiguous chunks of nearly equal length covering the range in order,
+  // each holding at least grain_size indices (a range shorter than grain_size stays one chunk).
+  auto split(size_type num_of_chunks, size_type grain_size = 1) const -> std::vector <IndexRange>
+  {
+    const auto length = size();
+    const auto max_chunks = length / (grain_size == 0 ? 1 : grain_size);
+    auto count = num_of_chunks < max_chunks ? num_of_chunks : max_chunks;
+    count = count == 0 ? 1 : count;
+    auto chunks = std::vector <IndexRange>{};
+    chunks.reserve(count);
+    for (size_type i = 0; i < count; ++i)
+    {
+      chunks.push_back(subrange(length * i / count, length * (i + 1) / count));
+    }
+    return chunks;
+  }
+};
+
+// Forward iterator over the points of a MultiIndexRange, dimension 0 varying fastest.
+template <class _Index, std::size_t _N>
+class matsulib::MultiIndexIterator
+{
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::array <_Index, _N>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type *;
+  using reference = const value_type &;
+
+protected:
+  value_type _point;
+  value_type _begin;
+  value_type _end;
+
+public:
+  MultiIndexIterator() : _point{}, _begin{}, _end{} {}
+  MultiIndexIterator(const value_type &point, const value_type &begin, const value_type &end) : _point{ point }, _begin{ begin }, _end{ end } {}
+
+public:
+  auto operator *() const -> const value_type & { return _point; }
+  auto operator ->() const -> const value_type * { return &_point; }
+  auto operator ++() -> MultiIndexIterator &
+  {
+    for (std::size_t dimension = 0; dimension + 1 < _N; ++dimension)
+    {
+      if (++_point[dimension] != _end[dimension])
+      {
+        return *this;
+      }
+      _point[dimension] = _begin[dimension];
+    }
+    ++_point[_N - 1];
+    return *this;
+  }
+  auto operator ++(int) -> MultiIndexIterator { auto previous = *this; ++*this; return previous; }
+
+  auto operator ==(const MultiIndexIterator &other) const -> bool { return _point == other._point; }
+  auto operator !=(const MultiIndexIterator &other) const -> bool { return _point != other._point; }
+};
+
+// Box of _N-dimensional points [begin[0], end[0]) x ... x [begin[_N - 1], end[_N - 1]), dimension 0 varying fastest.
+// Iterating yields std::array <_Index, _N> points ; each(func) calls func(x, y, ...) from plain nested loops.
+// tiled(sizes...) cuts the box into cache-sized tiles that can be handed to parallel_for.
+template <class _Index, std::size_t _N>
+class matsulib::MultiIndexRange
+{
+  template <class, std::size_t> friend class matsulib::TiledIndexRange;
+
+public:
+  using value_type = std::array <_Index, _N>;
+  using size_type = std::size_t;
+  using iterator = MultiIndexIterator <_Index, _N>;
+  using const_iterator = iterator;
+  static constexpr std::size_t dimension = _N;
+
+protected:
+  value_type _begin;
+  value_type _end;
+
+public:
+  // An end below begin is clamped, so that dimension (and the range) is empty.
+  MultiIndexRange(const value_type &begin, const value_type &end) : _begin{ begin }, _end{ end }
+  {
+    for (std::size_t d = 0; d < _N; ++d)
+    {
+      _end[d] = _end[d] < _begin[d] ? _begin[d] : _end[d];
+    }
+  }
+
+public:
+  MultiIndexRange() = delete;
+  MultiIndexRange(const MultiIndexRange &) = default;
+  MultiIndexRange(MultiIndexRange &&) = default;
+  MultiIndexRange &operator =(const MultiIndexRange &) = default;
+  MultiIndexRange &operator =(MultiIndexRange &&) = default;
+
+public:
+  auto begin() const -> iterator { return empty() ? end() : iterator{ _begin, _begin, _end }; }
+  auto end() const -> iterator
+  {
+    auto point = _begin;
+    point[_N - 1] = _end[_N - 1];
+    return iterator{ point, _begin, _end };
+  }
+
+  // number of points
+  auto size() const -> size_type
+  {
+    auto count = size_type(1);
+    for (std::size_t d = 0; d < _N; ++d)
+    {
+      count *= extent(d);
+    }
+    return count;
+  }
+  auto empty() const -> bool { return size() == 0; }
+  auto extent(std::size_t dimension) const -> size_type { return static_cast <size_type>(_end[dimension] - _begin[dimension]); }
+  auto range(std::size_t dimension) const -> IndexRange <_Index> { return IndexRange <_Index>{ _begin[dimension], _end[dimension] }; }
+  auto front() const -> value_type { return _begin; }
+  // point at position (in iteration order)
+  auto operator [](size_type position) const -> value_type
+  {
+    auto point = _begin;
+    for (std::size_t d = 0; d < _N; ++d)
+    {
+      point[d] = static_cast <_Index>(_begin[d] + position % extent(d));
+      position /= extent(d);
+    }
+    return point;
+  }
+
+  // slices [first, last) of the outermost dimension (rows of a 2D range, planes of a 3D range)
+  auto subrange(size_type first, size_type last) const -> MultiIndexRange
+  {
+    const auto outer = range(_N - 1).subrange(first, last);
+    auto begin = _begin;
+    auto end = _end;
+    begin[_N - 1] = outer.front();
+    end[_N - 1] = outer[outer.size()];
+    return MultiIndexRange{ begin, end };
+  }
+
+  // func(x, y, ...) for every point, as nested loops with dimension 0 innermost
+  template <class _Func>
+  auto each(_Func &&func) const -> const MultiIndexRange &
+  {
+    auto point = _begin;
+    each_impl(std::integral_constant <std::size_t, _N>{}, point, func);
+    return *this;
+  }
+
+  // tiles of sizes[0] x sizes[1] x ... points (smaller at the upper edges), dimension 0 varying fastest
+  template <class ..._Sizes>
+  auto tiled(_Sizes ...sizes) const -> TiledIndexRange <_Index, _N>
+  {
+    static_assert(sizeof...(_Sizes) == _N, "matsulib::MultiIndexRange::tiled() : one tile size per dimension !!");
+    return TiledIndexRange <_Index, _N>{ *this, { { static_cast <size_type>(sizes)... } } };
+  }
+
+protected:
+  template <class _Func>
+  auto each_impl(std::integral_constant <std::size_t, 0>, value_type &point, _Func &func) const -> void
+  {
+    call(func, point, std::make_index_sequence <_N>{});
+  }
+  template <std::size_t _Dimension, class _Func>
+  auto each_impl(std::integral_constant <std::size_t, _Dimension>, value_type &point, _Func &func) const -> void
+  {
+    for (point[_Dimension - 1] = _begin[_Dimension - 1]; point[_Dimension - 1] != _end[_Dimension - 1]; ++point[_Dimension - 1])
+    {
+      each_impl(std::integral_constant <std::size_t, _Dimension - 1>{}, point, func);
+    }
+  }
+  template <class _Func, std::size_t ..._Dimensions>
+  static auto call(_Func &func, const value_type &point, std::index_sequence <_Dimensions...>) -> void
+  {
+    func(point[_Dimensions]...);
+  }
+};
+
+template <class _Index, std::size_t _N>
+constexpr std::size_t matsulib::MultiIndexRange <_Index, _N>::dimension;
+
+// Iterator over the tiles of a TiledIndexRange ; valid while the TiledIndexRange lives.
+template <class _Index, std::size_t _N>
+class matsulib::TiledIndexIterator
+{
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = MultiIndexRange <_Index, _N>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = value_type;
+
+protected:
+  const TiledIndexRange <_Index, _N> *_tiles;
+  std::size_t _position;
+
+public:
+  TiledIndexIterator() : _tiles{ nullptr }, _position{ 0 } {}
+  TiledIndexIterator(const TiledIndexRange <_Index, _N> &tiles, std::size_t position) : _tiles{ &tiles }, _position{ position } {}
+
+public:
+  auto operator *() const -> value_type { return (*_tiles)[_position]; }
+  auto operator ++() -> TiledIndexIterator & { ++_position; return *this; }
+  auto operator ++(int) -> TiledIndexIterator { auto previous = *this; ++_position; return previous; }
+
+  auto operator ==(const TiledIndexIterator &other) const -> bool { return _position == other._position; }
+  auto operator !=(const TiledIndexIterator &other) const -> bool { return _position != other._position; }
+};
+
+// MultiIndexRange cut into tiles ; tile t is itself a MultiIndexRange.
+template <class _Index, std::size_t _N>
+class matsulib::TiledIndexRange
+{
+public:
+  using value_type = MultiIndexRange <_Index, _N>;
+  using size_type = std::size_t;
+  using iterator = TiledIndexIterator <_Index, _N>;
+  using const_iterator = iterator;
+
+protected:
+  value_type _range;
+  std::array <size_type, _N> _tile;
+  // tiles along each dimension
+  std::array <size_type, _N> _counts;
+
+public:
+  TiledIndexRange(const value_type &range, const std::array <size_type, _N> &tile) : _range{ range }, _tile{ tile }, _counts{}
+  {
+    for (std::size_t d = 0; d < _N; ++d)
+    {
+      _tile[d] = _tile[d] == 0 ? 1 : _tile[d];
+      _counts[d] = (_range.extent(d) + _tile[d] - 1) / _tile[d];
+    }
+  }
+
+public:
+  auto begin() const -> iterator { return iterator{ *this, 0 }; }
+  auto end() const -> iterator { return iterator{ *this, size() }; }
+
+  // number of tiles
+  auto size() const -> size_type
+  {
+    auto count = size_type(1);
+    for (std::size_t d = 0; d < _N; ++d)
+    {
+      count *= _counts[d];
+    }
+    return count;
+  }
+  auto empty() const -> bool { return size() == 0; }
+  auto count(std::size_t dimension) const -> size_type { return _counts[dimension]; }
+  auto operator [](size_type position) const -> value_type
+  {
+    auto begin = _range._begin;
+    auto end = _range._end;
+    for (std::size_t d = 0; d < _N; ++d)
+    {
+      const auto offset = position % _counts[d] * _tile[d];
+      position /= _counts[d];
+      begin[d] = static_cast <_Index>(_range._begin[d] + offset);
+      end[d] = _range.extent(d) - offset < _tile[d] ? _range._end[d] : static_cast <_Index>(begin[d] + _tile[d]);
+    }
+    return value_type{ begin, end };
+  }
+};
+
+// Forward iterator over the points of a CurveIndexRange.
+template <class _Index, class _Curve>
+class matsulib::CurveIndexIterator
+{
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::array <_Index, 2>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type *;
+  using reference = value_type;
+
+protected:
+  std::uint64_t _code;
+  std::uint64_t _width;
+  std::uint64_t _height;
+  unsigned _bits;
+  std::array <std::uint32_t, 2> _point;
+
+public:
+  CurveIndexIterator() : _code{ 0 }, _width{ 0 }, _height{ 0 }, _bits{ 0 }, _point{} {}
+  CurveIndexIterator(std::uint64_t code, unsigned bits, std::uint64_t width, std::uint64_t height) : _code{ code }, _width{ width }, _height{ height }, _bits{ bits }, _point{}
+  {
+    _code = _detail::index_range::curve_seek <_Curve>(_code, _bits, _width, _height, _point);
+  }
+
+public:
+  auto operator *() const -> value_type { return { { static_cast <_Index>(_point[0]), static_cast <_Index>(_point[1]) } }; }
+  auto operator ++() -> CurveIndexIterator &
+  {
+    _code = _detail::index_range::curve_seek <_Curve>(_code + 1, _bits, _width, _height, _point);
+    return *this;
+  }
+  auto operator ++(int) -> CurveIndexIterator { auto previous = *this; ++*this; return previous; }
+
+  auto operator ==(const CurveIndexIterator &other) const -> bool { return _code == other._code; }
+  auto operator !=(const CurveIndexIterator &other) const -> bool { return _code != other._code; }
+};
+
+// Points (x, y) of [0, width) x [0, height) along a space-filling curve (morton_range / hilbert_range).
+// The curve covers the enclosing power-of-two square ; points outside the box are skipped square by square.
+// Nearby points stay close in the order, so neighbourhood kernels touch fewer cache lines and pages than row by row.
+template <class _Index, class _Curve>
+class matsulib::CurveIndexRange
+{
+public:
+  using value_type = std::array <_Index, 2>;
+  using size_type = std::size_t;
+  using iterator = CurveIndexIterator <_Index, _Curve>;
+  using const_iterator = iterator;
+
+protected:
+  std::uint64_t _width;
+  std::uint64_t _height;
+  unsigned _bits;
+
+public:
+  CurveIndexRange(_Index width, _Index height)
+    : _width{ width < _Index{} ? 0 : static_cast <std::uint64_t>(width) }, _height{ height < _Index{} ? 0 : static_cast <std::uint64_t>(height) }, _bits{ 0 }
+  {
+    _bits = _detail::index_range::curve_bits(_width < _height ? _height : _width);
+    if (_width == 0 || _height == 0)
+    {
+      _width = _height = 0;
+    }
+  }
+
+public:
+  auto begin() const -> iterator { return iterator{ 0, _bits, _width, _height }; }
+  auto end() const -> iterator { return iterator{ std::uint64_t(1) << (2 * _bits), _bits, _width, _height }; }
+
+  auto size() const -> size_type { return static_cast <size_type>(_width * _height); }
+  auto empty() const -> bool { return size() == 0; }
+
+  // func(x, y) for every point in curve order, generated recursively quadrant by quadrant (faster than the iterators)
+  template <class _Func>
+  auto each(_Func &&func) const -> const CurveIndexRange &
+  {
+    const auto call = [&func](std::uint32_t x, std::uint32_t y) { func(static_cast <_Index>(x), static_cast <_Index>(y)); };
+    _detail::index_range::curve_visit <_Curve>(_bits, 0, 0, 0, _width, _height, call);
+    return *this;
+  }
+};
+
+// Iterator over the first indices of the full blocks of a SimdIndexRange (steps of _N).
+template <std::size_t _N, class _Index>
+class matsulib::SimdIndexIterator
+{
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = _Index;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const _Index *;
+  using reference = _Index;
+
+protected:
+  _Index _index;
+
+public:
+  SimdIndexIterator() : _index{} {}
+  explicit SimdIndexIterator(_Index index) : _index{ index } {}
+
+public:
+  auto operator *() const -> _Index { return _index; }
+  auto operator ++() -> SimdIndexIterator & { _index = static_cast <_Index>(_index + _N); return *this; }
+  auto operator ++(int) -> SimdIndexIterator { auto previous = *this; ++*this; return previous; }
+
+  auto operator ==(const SimdIndexIterator &other) const -> bool { return _index == other._index; }
+  auto operator !=(const SimdIndexIterator &other) const -> bool { return _index != other._index; }
+};
+
+// [begin, end) cut into a scalar head, full blocks of _N indices, and a scalar tail :
+//   for (auto i : range.head()) scalar(i);
+//   for (auto i : range) vector(i);          // i, i + 1, ..., i + _N - 1
+//   for (auto i : range.tail()) scalar(i);
+// or range.each(vector, scalar). The head is empty unless peel() moved the blocks onto an aligned address.
+template <std::size_t _N, class _Index>
+class matsulib::SimdIndexRange
+{
+  static_assert(_N > 0, "matsulib::SimdIndexRange : _N must not be 0 !!");
+
+public:
+  using value_type = _Index;
+  using size_type = std::size_t;
+  using iterator = SimdIndexIterator <_N, _Index>;
+  using const_iterator = iterator;
+  static constexpr std::size_t lanes = _N;
+
+protected:
+  _Index _begin;
+  _Index _body_begin;
+  _Index _body_end;
+  _Index _end;
+
+public:
+  SimdIndexRange(_Index begin, _Index end) : SimdIndexRange{ begin, begin, end < begin ? begin : end } {}
+
+protected:
+  SimdIndexRange(_Index begin, _Index body_begin, _Index end)
+    : _begin{ begin }, _body_begin{ body_begin }, _body_end{ static_cast <_Index>(body_begin + (end - body_begin) / _N * _N) }, _end{ end } {}
+
+public:
+  // first indices of the full blocks
+  auto begin() const -> iterator { return iterator{ _body_begin }; }
+  auto end() const -> iterator { return iterator{ _body_end }; }
+
+  auto head() const -> IndexRange <_Index> { return IndexRange <_Index>{ _begin, _body_begin }; }
+  auto body() const -> IndexRange <_Index> { return IndexRange <_Index>{ _body_begin, _body_end }; }
+  auto tail() const -> IndexRange <_Index> { return IndexRange <_Index>{ _body_end, _end }; }
+  auto num_of_blocks() const -> size_type { return static_cast <size_type>(_body_end - _body_begin) / _N; }
+  auto size() const -> size_type { return static_cast <size_type>(_end - _begin); }
+  auto empty() const -> bool { return _begin == _end; }
+
+  // Same indices with the head grown so that base + (first block index) is aligned to alignment bytes.
+  // Nothing is peeled when base is not aligned to sizeof(_T) itself.
+  template <class _T>
+  auto peel(const _T *base, std::size_t alignment = _N * sizeof(_T)) const -> SimdIndexRange
+  {
+    const auto address = reinterpret_cast <std::uintptr_t>(base + _begin);
+    const auto misalignment = alignment == 0 ? 0 : static_cast <std::size_t>(address % alignment);
+    if (misalignment == 0 || (alignment - misalignment) % sizeof(_T) != 0)
+    {
+      return SimdIndexRange{ _begin, _begin, _end };
+    }
+    const auto head_size = static_cast <size_type>((alignment - misalignment) / sizeof(_T));
+    return SimdIndexRange{ _begin, head_size < size() ? static_cast <_Index>(_begin + head_size) : _end, _end };
+  }
+
+  // scalar_func(i) for the head, block_func(i) for every full block [i, i + _N), scalar_func(i) for the tail
+  template <class _Block, class _Scalar>
+  auto each(_Block &&block_func, _Scalar &&scalar_func) const -> const SimdIndexRange &
+  {
+    for (auto i = _begin; i != _body_begin; ++i)
+    {
+      scalar_func(i);
+    }
+    for (auto i = _body_begin; i != _body_end; i = static_cast <_Index>(i + _N))
+    {
+      block_func(i);
+    }
+    for (auto i = _body_end; i != _end; ++i)
+    {
+      scalar_func(i);
+    }
+    return *this;
+  }
+};
 
-  auto begin() const -> IndexRange { return *this; }
-  auto end() const -> IndexRange { return *this; }
-};
\ No newline at end of file
+template <std::size_t _N, class _Index>
+constexpr std::size_t matsulib::SimdIndexRange <_N, _Index>::lanes;
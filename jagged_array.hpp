@@ -0,0 +1,360 @@
+﻿#pragma once
+
+#include <cstddef>
+
+namespace matsulib
+{
+  template <class _T> class JaggedArray;
+  template <class _Value> class JaggedRow;
+}
+
+#include "array.hpp"
+#include "execution.hpp"
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// View of one row of a JaggedArray (_Value is const for read-only rows); valid until the JaggedArray is modified.
+template <class _Value>
+class matsulib::JaggedRow
+{
+public:
+  using value_type = typename std::remove_const <_Value>::type;
+  using size_type = std::size_t;
+  using iterator = _Value *;
+
+protected:
+  _Value *_data;
+  size_type _size;
+
+public:
+  JaggedRow(_Value *data, size_type size) : _data{ data }, _size{ size } {}
+
+public:
+  auto size() const -> size_type { return _size; }
+  auto empty() const -> bool { return _size == 0; }
+  auto data() const -> _Value * { return _data; }
+  auto begin() const -> iterator { return _data; }
+  auto end() const -> iterator { return _data + _size; }
+  auto operator [](size_type index) const -> _Value & { return _data[index]; }
+  auto to_array() const -> Array <value_type> { return Array <value_type>(begin(), end()); }
+
+  template <class _Func>
+  auto each_with_index(_Func &&func) const -> const JaggedRow &
+  {
+    for (size_type i = 0; i < _size; ++i)
+    {
+      func(_data[i], i);
+    }
+    return *this;
+  }
+  template <class _Func>
+  auto each(_Func &&func) const -> const JaggedRow &
+  {
+    return each_with_index([&func](_Value &value, size_type) { func(value); });
+  }
+
+  template <class _DistType, class _Func>
+  auto map(_Func &&func) const -> Array <_DistType>
+  {
+    auto dst_array = Array <_DistType>{};
+    dst_array.reserve(_size);
+    for (size_type i = 0; i < _size; ++i)
+    {
+      dst_array.emplace_back(func(static_cast <const value_type &>(_data[i])));
+    }
+    return dst_array;
+  }
+  template <class _Func>
+  auto map(_Func &&func) const -> Array <value_type>
+  {
+    return map <value_type>(std::forward <_Func>(func));
+  }
+
+  template <class _DistType, class _Func>
+  auto inject(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _DistType
+  {
+    auto accumulation = std::move(initial_value);
+    for (size_type i = 0; i < _size; ++i)
+    {
+      accumulation = func(std::move(accumulation), static_cast <const value_type &>(_data[i]));
+    }
+    return accumulation;
+  }
+  template <class _Func>
+  auto inject(value_type initial_value, _Func &&func) const -> value_type
+  {
+    return inject <value_type>(std::move(initial_value), std::forward <_Func>(func));
+  }
+};
+
+// Rows of different lengths in compressed sparse row layout : the values of all rows are stored back to back in values(),
+// row r is values()[offsets()[r], offsets()[r + 1]). Replaces Array <Array <_T>> with two allocations in total.
+// Builder fills one with a count pass and a fill pass.
+template <class _T>
+class matsulib::JaggedArray
+{
+  template <class> friend class matsulib::JaggedArray;
+
+public:
+  using value_type = _T;
+  using size_type = std::size_t;
+  using row_type = JaggedRow <_T>;
+  using const_row_type = JaggedRow <const _T>;
+
+  class Builder;
+
+protected:
+  Array <_T> _values;
+  Array <size_type> _offsets;
+
+public:
+  JaggedArray() : _values{}, _offsets(1, 0) {}
+  // row_sizes [r] value-initialized values in row r
+  explicit JaggedArray(const Array <size_type> &row_sizes) : JaggedArray{}
+  {
+    _offsets.reserve(row_sizes.size() + 1);
+    for (const auto row_size : row_sizes)
+    {
+      _offsets.push_back(_offsets.back() + row_size);
+    }
+    _values.resize(_offsets.back());
+  }
+  template <class _Allocator>
+  explicit JaggedArray(const Array <Array <_T, _Allocator>> &rows) : JaggedArray{}
+  {
+    auto num_of_values = size_type(0);
+    for (const auto &row : rows)
+    {
+      num_of_values += row.size();
+    }
+    _values.reserve(num_of_values);
+    _offsets.reserve(rows.size() + 1);
+    for (const auto &row : rows)
+    {
+      push_back(row.begin(), row.end());
+    }
+  }
+  JaggedArray(std::initializer_list <std::initializer_list <_T>> rows) : JaggedArray{}
+  {
+    for (const auto &row : rows)
+    {
+      push_back(row.begin(), row.end());
+    }
+  }
+
+public:
+  // number of rows
+  auto size() const -> size_type { return _offsets.size() - 1; }
+  auto empty() const -> bool { return size() == 0; }
+  auto num_of_values() const -> size_type { return _values.size(); }
+  auto values() -> Array <_T> & { return _values; }
+  auto values() const -> const Array <_T> & { return _values; }
+  auto offsets() const -> const Array <size_type> & { return _offsets; }
+
+  auto row(size_type index) -> row_type { return row_type{ _values.data() + _offsets[index], _offsets[index + 1] - _offsets[index] }; }
+  auto row(size_type index) const -> const_row_type { return const_row_type{ _values.data() + _offsets[index], _offsets[index + 1] - _offsets[index] }; }
+  auto operator [](size_type index) -> row_type { return row(index); }
+  auto operator [](size_type index) const -> const_row_type { return row(index); }
+  auto at(size_type index) -> row_type
+  {
+    check_row(index);
+    return row(index);
+  }
+  auto at(size_type index) const -> const_row_type
+  {
+    check_row(index);
+    return row(index);
+  }
+
+  // appends [first, last) as a new row
+  template <class _Iterator>
+  auto push_back(_Iterator first, _Iterator last) -> void
+  {
+    _values.insert(_values.end(), first, last);
+    _offsets.push_back(_values.size());
+  }
+  auto push_back(std::initializer_list <_T> values) -> void { push_back(values.begin(), values.end()); }
+  auto to_arrays() const -> Array <Array <_T>>
+  {
+    auto dst_array = Array <Array <_T>>{};
+    dst_array.reserve(size());
+    for (size_type r = 0; r < size(); ++r)
+    {
+      dst_array.push_back(row(r).to_array());
+    }
+    return dst_array;
+  }
+
+public:
+  // func(row, row_index) for every row
+  template <class _Func>
+  auto each_row_with_index(_Func &&func) -> JaggedArray &
+  {
+    for (size_type r = 0; r < size(); ++r)
+    {
+      func(row(r), r);
+    }
+    return *this;
+  }
+  template <class _Func>
+  auto each_row_with_index(_Func &&func) const -> const JaggedArray &
+  {
+    for (size_type r = 0; r < size(); ++r)
+    {
+      func(row(r), r);
+    }
+    return *this;
+  }
+  template <class _Func>
+  auto each_row(_Func &&func) -> JaggedArray & { return each_row_with_index([&func](row_type row, size_type) { func(row); }); }
+  template <class _Func>
+  auto each_row(_Func &&func) const -> const JaggedArray & { return each_row_with_index([&func](const_row_type row, size_type) { func(row); }); }
+
+  // Rows are split between the threads of the shared Scheduler (policy.grain_size counts rows).
+  template <class _Func>
+  auto each_row_with_index(const execution::ParallelPolicy &policy, _Func &&func) -> JaggedArray &
+  {
+    parallel_rows(policy, [&](size_type r) { func(row(r), r); });
+    return *this;
+  }
+  template <class _Func>
+  auto each_row_with_index(const execution::ParallelPolicy &policy, _Func &&func) const -> const JaggedArray &
+  {
+    parallel_rows(policy, [&](size_type r) { func(row(r), r); });
+    return *this;
+  }
+  template <class _Func>
+  auto each_row(const execution::ParallelPolicy &policy, _Func &&func) -> JaggedArray & { return each_row_with_index(policy, [&func](row_type row, size_type) { func(row); }); }
+  template <class _Func>
+  auto each_row(const execution::ParallelPolicy &policy, _Func &&func) const -> const JaggedArray & { return each_row_with_index(policy, [&func](const_row_type row, size_type) { func(row); }); }
+
+  // one result per row : func(row)
+  template <class _DistType, class _Func>
+  auto map_rows(_Func &&func) const -> Array <_DistType>
+  {
+    auto dst_array = Array <_DistType>{};
+    dst_array.reserve(size());
+    each_row([&](const_row_type row) { dst_array.emplace_back(func(row)); });
+    return dst_array;
+  }
+  template <class _DistType, class _Func>
+  auto map_rows(const execution::ParallelPolicy &policy, _Func &&func) const -> Array <_DistType>
+  {
+    auto dst_array = Array <_DistType>{};
+    _detail::array::parallel_map(_detail::execution::num_of_chunks(policy, size()), size(), dst_array, [&](size_type r) { return func(row(r)); });
+    return dst_array;
+  }
+
+  // one accumulation per row : func(accumulation, value) from initial_value
+  template <class _DistType, class _Func>
+  auto inject_rows(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> Array <_DistType>
+  {
+    return map_rows <_DistType>([&](const_row_type row) { return row.template inject <_DistType>(initial_value, func); });
+  }
+  template <class _Func>
+  auto inject_rows(_T initial_value, _Func &&func) const -> Array <_T>
+  {
+    return inject_rows <_T>(std::move(initial_value), std::forward <_Func>(func));
+  }
+  template <class _DistType, class _Func>
+  auto inject_rows(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> Array <_DistType>
+  {
+    return map_rows <_DistType>(policy, [&](const_row_type row) { return row.template inject <_DistType>(initial_value, func); });
+  }
+  template <class _Func>
+  auto inject_rows(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func) const -> Array <_T>
+  {
+    return inject_rows <_T>(policy, std::move(initial_value), std::forward <_Func>(func));
+  }
+
+  // same rows, every value mapped by func(value)
+  template <class _DistType, class _Func>
+  auto map(_Func &&func) const -> JaggedArray <_DistType>
+  {
+    auto dst = JaggedArray <_DistType>{};
+    dst._values = _values.template map <_DistType>(std::forward <_Func>(func));
+    dst._offsets = _offsets;
+    return dst;
+  }
+  template <class _Func>
+  auto map(_Func &&func) const -> JaggedArray
+  {
+    return map <_T>(std::forward <_Func>(func));
+  }
+
+protected:
+  auto check_row(size_type index) const -> void
+  {
+    if (index >= size())
+    {
+      throw std::out_of_range{ "matsulib::JaggedArray::at() : Out Of Range!!" };
+    }
+  }
+  template <class _Func>
+  auto parallel_rows(const execution::ParallelPolicy &policy, _Func &&func) const -> void
+  {
+    const auto num_of_rows = size();
+    _detail::execution::run_chunks(_detail::execution::num_of_chunks(policy, num_of_rows), num_of_rows, [&](std::size_t, size_type begin, size_type end)
+    {
+      for (auto r = begin; r < end; ++r)
+      {
+        func(r);
+      }
+    });
+  }
+};
+
+// Two pass construction of a JaggedArray with a single allocation of the values :
+//   auto builder = JaggedArray <int>::Builder{ num_of_rows };
+//   builder.count(row) ...;      // count pass : one call per value (or count(row, n))
+//   builder.allocate();
+//   builder.push(row, value) ...; // fill pass : the same number of values per row, in any row order
+//   auto jagged = builder.build();
+template <class _T>
+class matsulib::JaggedArray <_T>::Builder
+{
+protected:
+  JaggedArray <_T> _jagged;
+  // values counted per row, then the next free position of each row
+  Array <size_type> _cursors;
+
+public:
+  explicit Builder(size_type num_of_rows) : _jagged{}, _cursors(num_of_rows, 0) {}
+
+public:
+  auto count(size_type row, size_type num_of_values = 1) -> void { _cursors[row] += num_of_values; }
+  auto allocate() -> void
+  {
+    auto &offsets = _jagged._offsets;
+    offsets.resize(_cursors.size() + 1);
+    offsets[0] = 0;
+    for (size_type r = 0; r < _cursors.size(); ++r)
+    {
+      offsets[r + 1] = offsets[r] + _cursors[r];
+      _cursors[r] = offsets[r];
+    }
+    _jagged._values.resize(offsets.back());
+  }
+  // throws when row already holds every value counted for it
+  auto push(size_type row, _T value) -> void
+  {
+    if (_cursors[row] >= _jagged._offsets[row + 1])
+    {
+      throw std::logic_error{ "matsulib::JaggedArray::Builder::push() : Count Mismatch!!" };
+    }
+    _jagged._values[_cursors[row]++] = std::move(value);
+  }
+  auto build() -> JaggedArray <_T>
+  {
+    for (size_type r = 0; r < _cursors.size(); ++r)
+    {
+      if (_cursors[r] != _jagged._offsets[r + 1])
+      {
+        throw std::logic_error{ "matsulib::JaggedArray::Builder::build() : Count Mismatch!!" };
+      }
+    }
+    return std::move(_jagged);
+  }
+};
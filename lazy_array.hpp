@@ -0,0 +1,169 @@
+﻿#pragma once
+
+#include "array.hpp"
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace matsulib
+{
+  namespace _detail
+  {
+    namespace lazy
+    {
+      // A source pushes every value to sink(value) in order.
+      // size_hint() is an upper bound of the number of pushed values, get_allocator() is the source Array's allocator.
+      template <class _T, class _Allocator>
+      struct ArraySource
+      {
+      public:
+        using allocator_type = _Allocator;
+
+        const matsulib::Array <_T, _Allocator> *array;
+
+        template <class _Sink>
+        auto operator ()(_Sink &&sink) const -> void
+        {
+          const auto length = array->size();
+          const auto data = array->data();
+          for (std::size_t i = 0; i < length; ++i)
+          {
+            sink(data[i]);
+          }
+        }
+        auto size_hint() const -> std::size_t { return array->size(); }
+        auto get_allocator() const -> allocator_type { return array->get_allocator(); }
+      };
+
+      template <class _Source, class _Func>
+      struct SelectStage
+      {
+      public:
+        using allocator_type = typename _Source::allocator_type;
+
+        _Source source;
+        _Func func;
+
+        template <class _Sink>
+        auto operator ()(_Sink &&sink) const -> void
+        {
+          source([&](const auto &value)
+          {
+            if (func(value))
+            {
+              sink(value);
+            }
+          });
+        }
+        auto size_hint() const -> std::size_t { return source.size_hint(); }
+        auto get_allocator() const -> allocator_type { return source.get_allocator(); }
+      };
+
+      template <class _DistType, class _Source, class _Func>
+      struct MapStage
+      {
+      public:
+        using allocator_type = typename _Source::allocator_type;
+
+        _Source source;
+        _Func func;
+
+        template <class _Sink>
+        auto operator ()(_Sink &&sink) const -> void
+        {
+          source([&](const auto &value)
+          {
+            sink(static_cast <_DistType>(func(value)));
+          });
+        }
+        auto size_hint() const -> std::size_t { return source.size_hint(); }
+        auto get_allocator() const -> allocator_type { return source.get_allocator(); }
+      };
+    }
+  }
+}
+
+// Deferred chain of select / map over an Array.
+// Nothing runs until a terminal operation (each / inject / to_array), which walks the source once
+// and pushes every value through all stages without intermediate Arrays.
+// The source Array must outlive the LazyArray, and callables must be callable as const.
+template <class _T, class _Source>
+class matsulib::LazyArray
+{
+protected:
+  _Source _source;
+
+public:
+  explicit LazyArray(_Source source) : _source{ std::move(source) } {}
+
+public:
+  LazyArray() = delete;
+  LazyArray(const LazyArray &) = default;
+  LazyArray(LazyArray &&) = default;
+  LazyArray &operator =(const LazyArray &) = default;
+  LazyArray &operator =(LazyArray &&) = default;
+
+public:
+  template <class _Func>
+  auto select(_Func func) const -> LazyArray <_T, _detail::lazy::SelectStage <_Source, _Func>>
+  {
+    return LazyArray <_T, _detail::lazy::SelectStage <_Source, _Func>>{ { _source, std::move(func) } };
+  }
+
+  template <class _DistType, class _Func>
+  auto map(_Func func) const -> LazyArray <_DistType, _detail::lazy::MapStage <_DistType, _Source, _Func>>
+  {
+    return LazyArray <_DistType, _detail::lazy::MapStage <_DistType, _Source, _Func>>{ { _source, std::move(func) } };
+  }
+  template <class _Func>
+  auto map(_Func func) const -> LazyArray <_T, _detail::lazy::MapStage <_T, _Source, _Func>>
+  {
+    return map <_T>(std::move(func));
+  }
+
+  template <class _Func>
+  auto each(_Func &&func) const -> void
+  {
+    _source([&func](const _T &value) { func(value); });
+  }
+
+  template <class _DistType, class _Func>
+  auto inject(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _DistType
+  {
+    auto accumulation = std::move(initial_value);
+    _source([&](const _T &value) { accumulation = func(std::move(accumulation), value); });
+    return accumulation;
+  }
+  template <class _Func>
+  auto inject(_T initial_value, _Func &&func) const -> _T
+  {
+    return inject <_T>(std::move(initial_value), std::forward <_Func>(func));
+  }
+  template <class _DistType, class _Func>
+  auto inject(_Func &&func) const -> _DistType
+  {
+    return inject <_DistType>(_DistType{}, std::forward <_Func>(func));
+  }
+  template <class _Func>
+  auto inject(_Func &&func) const -> _T
+  {
+    return inject <_T>(_T{}, std::forward <_Func>(func));
+  }
+
+  using array_type = Array <_T, typename std::allocator_traits <typename _Source::allocator_type>::template rebind_alloc <_T>>;
+
+  auto to_array() const -> array_type
+  {
+    auto dst_array = array_type(typename array_type::allocator_type(_source.get_allocator()));
+    dst_array.reserve(_source.size_hint());
+    _source([&dst_array](const _T &value) { dst_array.push_back(value); });
+    return dst_array;
+  }
+};
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::lazy() const -> LazyArray <_T, _detail::lazy::ArraySource <_T, _Allocator>>
+{
+  return LazyArray <_T, _detail::lazy::ArraySource <_T, _Allocator>>{ { this } };
+}
\ No newline at end of file
@@ -0,0 +1,452 @@
+﻿#pragma once
+
+#include <cstddef>
+
+namespace matsulib
+{
+  template <class _T> class MappedArray;
+}
+
+#include "array.hpp"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace matsulib
+{
+  namespace mapped_array
+  {
+    // Expected access pattern, passed to the OS as a paging hint.
+    enum class Access : int
+    {
+      NORMAL = 0,
+      SEQUENTIAL = 1,
+      RANDOM = 2
+    };
+  }
+
+  namespace _detail
+  {
+    namespace mapped_array
+    {
+      // File layout written by Array::save_binary() : this header, then the raw elements from data_offset.
+      struct Header
+      {
+      public:
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t element_size;
+        std::uint64_t count;
+        std::uint64_t data_offset;
+        unsigned char reserved[32];
+      };
+      static_assert(sizeof(Header) == 64, "matsulib::_detail::mapped_array::Header must be 64 bytes");
+
+      constexpr char magic[8] = { 'M', 'A', 'T', 'S', 'U', 'A', 'R', 'R' };
+      constexpr std::uint32_t version = 1;
+
+      inline auto make_header(std::size_t element_size, std::size_t count) -> Header
+      {
+        auto header = Header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.element_size = static_cast <std::uint32_t>(element_size);
+        header.count = count;
+        header.data_offset = sizeof(Header);
+        return header;
+      }
+
+      // header + data in a single gathered write
+      inline auto write(const std::string &filename, const Header &header, const void *data, std::size_t data_size) -> void
+      {
+#if defined(_WIN32)
+        const auto file = ::CreateFileA(filename.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+          throw std::runtime_error{ "matsulib::Array::save_binary() : Could Not Open!!" };
+        }
+        auto ok = true;
+        const unsigned char *chunks[2] = { reinterpret_cast <const unsigned char *>(&header), static_cast <const unsigned char *>(data) };
+        std::size_t sizes[2] = { sizeof(Header), data_size };
+        for (int chunk = 0; chunk < 2 && ok; ++chunk)
+        {
+          while (sizes[chunk] > 0 && ok)
+          {
+            const auto request = static_cast <DWORD>(sizes[chunk] < 0x40000000u ? sizes[chunk] : 0x40000000u);
+            DWORD written = 0;
+            ok = ::WriteFile(file, chunks[chunk], request, &written, nullptr) != 0 && written > 0;
+            chunks[chunk] += written;
+            sizes[chunk] -= written;
+          }
+        }
+        ::CloseHandle(file);
+#else
+        const auto fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+          throw std::runtime_error{ "matsulib::Array::save_binary() : Could Not Open!!" };
+        }
+        auto ok = true;
+        ::iovec chunks[2];
+        chunks[0].iov_base = const_cast <Header *>(&header);
+        chunks[0].iov_len = sizeof(Header);
+        chunks[1].iov_base = const_cast <void *>(data);
+        chunks[1].iov_len = data_size;
+        auto first = 0;
+        while (first < 2 && ok)
+        {
+          const auto written = ::writev(fd, chunks + first, 2 - first);
+          if (written < 0)
+          {
+            ok = errno == EINTR;
+            continue;
+          }
+          // resume after a partial write
+          auto rest = static_cast <std::size_t>(written);
+          while (first < 2 && rest >= chunks[first].iov_len)
+          {
+            rest -= chunks[first].iov_len;
+            ++first;
+          }
+          if (first < 2)
+          {
+            chunks[first].iov_base = static_cast <unsigned char *>(chunks[first].iov_base) + rest;
+            chunks[first].iov_len -= rest;
+          }
+        }
+        ok = ::close(fd) == 0 && ok;
+#endif
+        if (!ok)
+        {
+          throw std::runtime_error{ "matsulib::Array::save_binary() : Could Not Write!!" };
+        }
+      }
+
+      // Read-only mapping of a whole file.
+      class Mapping
+      {
+      protected:
+        const unsigned char *_address = nullptr;
+        std::size_t _size = 0;
+#if defined(_WIN32)
+        HANDLE _file = INVALID_HANDLE_VALUE;
+        HANDLE _mapping = nullptr;
+#endif
+
+      public:
+        Mapping(const std::string &filename, matsulib::mapped_array::Access access)
+        {
+#if defined(_WIN32)
+          const auto flags = access == matsulib::mapped_array::Access::SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : access == matsulib::mapped_array::Access::RANDOM ? FILE_FLAG_RANDOM_ACCESS : 0;
+          _file = ::CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | flags, nullptr);
+          LARGE_INTEGER size;
+          if (_file == INVALID_HANDLE_VALUE || !::GetFileSizeEx(_file, &size))
+          {
+            close();
+            throw std::runtime_error{ "matsulib::MappedArray() : Could Not Open!!" };
+          }
+          _size = static_cast <std::size_t>(size.QuadPart);
+          _mapping = _size == 0 ? nullptr : ::CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+          _address = _mapping == nullptr ? nullptr : static_cast <const unsigned char *>(::MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+          if (_address == nullptr)
+          {
+            close();
+            throw std::runtime_error{ "matsulib::MappedArray() : Could Not Map!!" };
+          }
+#else
+          const auto fd = ::open(filename.c_str(), O_RDONLY);
+          struct ::stat status;
+          if (fd < 0 || ::fstat(fd, &status) != 0)
+          {
+            if (fd >= 0)
+            {
+              ::close(fd);
+            }
+            throw std::runtime_error{ "matsulib::MappedArray() : Could Not Open!!" };
+          }
+          _size = static_cast <std::size_t>(status.st_size);
+          const auto address = _size == 0 ? MAP_FAILED : ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+          ::close(fd);
+          if (address == MAP_FAILED)
+          {
+            throw std::runtime_error{ "matsulib::MappedArray() : Could Not Map!!" };
+          }
+          _address = static_cast <const unsigned char *>(address);
+          // pages are faulted in on demand; the hint only tunes read-ahead
+          const auto advice = access == matsulib::mapped_array::Access::SEQUENTIAL ? MADV_SEQUENTIAL : access == matsulib::mapped_array::Access::RANDOM ? MADV_RANDOM : MADV_NORMAL;
+          ::madvise(address, _size, advice);
+#endif
+        }
+        Mapping(Mapping &&other) { swap(other); }
+        Mapping &operator =(Mapping &&other)
+        {
+          if (this != &other)
+          {
+            close();
+            swap(other);
+          }
+          return *this;
+        }
+        ~Mapping() { close(); }
+
+        Mapping() = delete;
+        Mapping(const Mapping &) = delete;
+        Mapping &operator =(const Mapping &) = delete;
+
+      public:
+        auto address() const -> const unsigned char * { return _address; }
+        auto size() const -> std::size_t { return _size; }
+
+      protected:
+        auto swap(Mapping &other) -> void
+        {
+          std::swap(_address, other._address);
+          std::swap(_size, other._size);
+#if defined(_WIN32)
+          std::swap(_file, other._file);
+          std::swap(_mapping, other._mapping);
+#endif
+        }
+        auto close() -> void
+        {
+#if defined(_WIN32)
+          if (_address != nullptr)
+          {
+            ::UnmapViewOfFile(_address);
+          }
+          if (_mapping != nullptr)
+          {
+            ::CloseHandle(_mapping);
+          }
+          if (_file != INVALID_HANDLE_VALUE)
+          {
+            ::CloseHandle(_file);
+          }
+          _file = INVALID_HANDLE_VALUE;
+          _mapping = nullptr;
+#else
+          if (_address != nullptr)
+          {
+            ::munmap(const_cast <unsigned char *>(_address), _size);
+          }
+#endif
+          _address = nullptr;
+          _size = 0;
+        }
+      };
+    }
+  }
+}
+
+// Read-only view of a file written by Array <_T>::save_binary(), backed by a memory mapping.
+// Nothing is read up front : pages are faulted in when elements are touched.
+// map / select return ordinary Arrays.
+template <class _T>
+class matsulib::MappedArray
+{
+  static_assert(std::is_trivially_copyable <_T>::value, "matsulib::MappedArray : _T must be trivially copyable !!");
+
+public:
+  using value_type = _T;
+  using size_type = std::size_t;
+  using const_iterator = const _T *;
+
+protected:
+  _detail::mapped_array::Mapping _mapping;
+  const _T *_data = nullptr;
+  size_type _size = 0;
+
+public:
+  explicit MappedArray(const std::string &filename, mapped_array::Access access = mapped_array::Access::SEQUENTIAL)
+    : _mapping{ filename, access }
+  {
+    auto header = _detail::mapped_array::Header{};
+    if (_mapping.size() < sizeof(header))
+    {
+      throw std::runtime_error{ "matsulib::MappedArray() : Broken Header!!" };
+    }
+    std::memcpy(&header, _mapping.address(), sizeof(header));
+    if (std::memcmp(header.magic, _detail::mapped_array::magic, sizeof(header.magic)) != 0 || header.version != _detail::mapped_array::version)
+    {
+      throw std::runtime_error{ "matsulib::MappedArray() : Broken Header!!" };
+    }
+    if (header.element_size != sizeof(_T) || header.data_offset % alignof(_T) != 0 || header.data_offset > _mapping.size() || header.count > (_mapping.size() - header.data_offset) / sizeof(_T))
+    {
+      throw std::runtime_error{ "matsulib::MappedArray() : Type Or Size Mismatch!!" };
+    }
+    _data = reinterpret_cast <const _T *>(_mapping.address() + header.data_offset);
+    _size = static_cast <size_type>(header.count);
+  }
+
+public:
+  MappedArray(MappedArray &&other)
+    : _mapping{ std::move(other._mapping) }, _data{ other._data }, _size{ other._size }
+  {
+    other._data = nullptr;
+    other._size = 0;
+  }
+  MappedArray &operator =(MappedArray &&other)
+  {
+    if (this != &other)
+    {
+      _mapping = std::move(other._mapping);
+      _data = other._data;
+      _size = other._size;
+      other._data = nullptr;
+      other._size = 0;
+    }
+    return *this;
+  }
+
+public:
+  MappedArray() = delete;
+  MappedArray(const MappedArray &) = delete;
+  MappedArray &operator =(const MappedArray &) = delete;
+
+public:
+  auto size() const -> size_type { return _size; }
+  auto empty() const -> bool { return _size == 0; }
+  auto data() const -> const _T * { return _data; }
+  auto begin() const -> const_iterator { return _data; }
+  auto end() const -> const_iterator { return _data + _size; }
+  auto operator [](size_type index) const -> const _T & { return _data[index]; }
+  auto at(size_type index) const -> const _T &
+  {
+    if (index >= _size)
+    {
+      throw std::out_of_range{ "matsulib::MappedArray::at() : Out Of Range!!" };
+    }
+    return _data[index];
+  }
+  auto to_array() const -> Array <_T>
+  {
+    return Array <_T>(begin(), end());
+  }
+
+public:
+  template <class _Func>
+  auto each_with_index(_Func &&func) const -> const MappedArray &
+  {
+    for (size_type i = 0; i < _size; ++i)
+    {
+      func(_data[i], i);
+    }
+    return *this;
+  }
+  template <class _Func>
+  auto each(_Func &&func) const -> const MappedArray &
+  {
+    return each_with_index([&func](const _T &value, size_type) { func(value); });
+  }
+
+  template <class _Func>
+  auto select_with_index(_Func &&func) const -> Array <_T>
+  {
+    auto dst_array = Array <_T>{};
+    for (size_type i = 0; i < _size; ++i)
+    {
+      if (func(_data[i], i))
+      {
+        dst_array.push_back(_data[i]);
+      }
+    }
+    return dst_array;
+  }
+  template <class _Func>
+  auto select(_Func &&func) const -> Array <_T>
+  {
+    return select_with_index([&func](const _T &value, size_type) { return func(value); });
+  }
+
+  template <class _DistType, class _Func>
+  auto map_with_index(_Func &&func) const -> Array <_DistType>
+  {
+    auto dst_array = Array <_DistType>{};
+    dst_array.reserve(_size);
+    for (size_type i = 0; i < _size; ++i)
+    {
+      dst_array.emplace_back(func(_data[i], i));
+    }
+    return dst_array;
+  }
+  template <class _Func>
+  auto map_with_index(_Func &&func) const -> Array <_T>
+  {
+    return map_with_index <_T>(std::forward <_Func>(func));
+  }
+  template <class _DistType, class _Func>
+  auto map(_Func &&func) const -> Array <_DistType>
+  {
+    return map_with_index <_DistType>([&func](const _T &value, size_type) { return func(value); });
+  }
+  template <class _Func>
+  auto map(_Func &&func) const -> Array <_T>
+  {
+    return map <_T>(std::forward <_Func>(func));
+  }
+
+  template <class _DistType, class _Func>
+  auto inject_with_index(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _DistType
+  {
+    auto accumulation = std::move(initial_value);
+    for (size_type i = 0; i < _size; ++i)
+    {
+      accumulation = func(std::move(accumulation), _data[i], i);
+    }
+    return accumulation;
+  }
+  template <class _Func>
+  auto inject_with_index(_T initial_value, _Func &&func) const -> _T
+  {
+    return inject_with_index <_T>(std::move(initial_value), std::forward <_Func>(func));
+  }
+  template <class _DistType, class _Func>
+  auto inject(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _DistType
+  {
+    return inject_with_index <_DistType>(std::move(initial_value), [&func](_DistType accumulation, const _T &value, size_type) { return func(std::move(accumulation), value); });
+  }
+  template <class _Func>
+  auto inject(_T initial_value, _Func &&func) const -> _T
+  {
+    return inject <_T>(std::move(initial_value), std::forward <_Func>(func));
+  }
+  template <class _DistType, class _Func>
+  auto inject(_Func &&func) const -> _DistType
+  {
+    return inject <_DistType>(_DistType{}, std::forward <_Func>(func));
+  }
+  template <class _Func>
+  auto inject(_Func &&func) const -> _T
+  {
+    return inject <_T>(_T{}, std::forward <_Func>(func));
+  }
+};
+
+template <class _T, class _Allocator>
+inline
+auto matsulib::Array <_T, _Allocator>::save_binary(const std::string &filename) const -> void
+{
+  static_assert(std::is_trivially_copyable <_T>::value, "matsulib::Array::save_binary() : _T must be trivially copyable !!");
+  const auto header = _detail::mapped_array::make_header(sizeof(_T), this->size());
+  _detail::mapped_array::write(filename, header, this->data(), this->size() * sizeof(_T));
+}
\ No newline at end of file
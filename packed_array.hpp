@@ -0,0 +1,446 @@
+﻿#pragma once
+
+#include <cstddef>
+
+namespace matsulib
+{
+  template <class _T> class PackedArray;
+}
+
+#include "array.hpp"
+#include "execution.hpp"
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace matsulib
+{
+  namespace _detail
+  {
+    namespace packed_array
+    {
+      // values per compressed block
+      constexpr std::size_t BLOCK = 128;
+
+      // 8 bytes from bytes as a little-endian word (compiles to a single load on little-endian targets)
+      inline auto load(const unsigned char *bytes) -> std::uint64_t
+      {
+        return std::uint64_t(bytes[0]) | std::uint64_t(bytes[1]) << 8 | std::uint64_t(bytes[2]) << 16 | std::uint64_t(bytes[3]) << 24
+          | std::uint64_t(bytes[4]) << 32 | std::uint64_t(bytes[5]) << 40 | std::uint64_t(bytes[6]) << 48 | std::uint64_t(bytes[7]) << 56;
+      }
+      // Value i of a block occupies bits [i * width, (i + 1) * width) of the block's bytes taken as one little-endian number
+      // (2 * width words per block). One extra readable word must follow the block.
+      inline auto extract(const std::uint64_t *words, unsigned width, std::size_t index) -> std::uint64_t
+      {
+        const auto bytes = reinterpret_cast <const unsigned char *>(words);
+        const auto bit = index * width;
+        const auto shift = static_cast <unsigned>(bit % 8);
+        const auto mask = width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << width) - 1;
+        auto value = load(bytes + bit / 8) >> shift;
+        if (shift + width > 64)
+        {
+          value |= std::uint64_t(bytes[bit / 8 + 8]) << (64 - shift);
+        }
+        return value & mask;
+      }
+
+      // 8 values take exactly _Width bytes, so within a group of 8 every byte offset and shift is a constant.
+      // values [lane] = reference + residual, or the running sum of the residuals from reference for delta blocks
+      template <unsigned _Width, std::size_t ..._Lanes>
+      inline auto unpack_group(const unsigned char *bytes, bool delta, std::uint64_t &reference, std::uint64_t *values, std::index_sequence <_Lanes...>) -> void
+      {
+        using Swallow = int[];
+        const auto mask = _Width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << (_Width % 64)) - 1;
+        // a value wider than 56 bits may reach into a ninth byte
+        std::uint64_t residuals[] = { ((load(bytes + _Lanes * _Width / 8) >> (_Lanes * _Width % 8))
+          | (_Width > 56 && _Lanes * _Width % 8 != 0 ? std::uint64_t(bytes[_Lanes * _Width / 8 + 8]) << ((64 - _Lanes * _Width % 8) % 64) : 0)) & mask... };
+        if (delta)
+        {
+          (void)Swallow{ 0, (values[_Lanes] = reference += residuals[_Lanes], 0)... };
+        }
+        else
+        {
+          (void)Swallow{ 0, (values[_Lanes] = reference + residuals[_Lanes], 0)... };
+        }
+      }
+      template <unsigned _Width>
+      inline auto unpack(const std::uint64_t *words, bool delta, std::uint64_t reference, std::uint64_t *values) -> void
+      {
+        const auto bytes = reinterpret_cast <const unsigned char *>(words);
+        for (std::size_t group = 0; group < BLOCK / 8; ++group)
+        {
+          unpack_group <_Width>(bytes + group * _Width, delta, reference, values + group * 8, std::make_index_sequence <8>{});
+        }
+      }
+
+      using Unpack = void (*)(const std::uint64_t *, bool, std::uint64_t, std::uint64_t *);
+      template <std::size_t ..._Widths>
+      inline auto unpack_table(std::index_sequence <_Widths...>) -> const Unpack *
+      {
+        static const Unpack table[] = { &unpack <static_cast <unsigned>(_Widths + 1)>... };
+        return table;
+      }
+      // Rebuilds the values of a whole block with the kernel of its width.
+      inline auto unpack(unsigned width, const std::uint64_t *words, bool delta, std::uint64_t reference, std::uint64_t *values) -> void
+      {
+        static const auto table = unpack_table(std::make_index_sequence <64>{});
+        if (width == 0)
+        {
+          for (std::size_t i = 0; i < BLOCK; ++i)
+          {
+            values[i] = reference;
+          }
+          return;
+        }
+        table[width - 1](words, delta, reference, values);
+      }
+
+      inline auto pack(const std::uint64_t *values, unsigned width, std::uint64_t *words) -> void
+      {
+        for (unsigned i = 0; i < 2 * width; ++i)
+        {
+          words[i] = 0;
+        }
+        if (width == 0)
+        {
+          return;
+        }
+        for (std::size_t i = 0; i < BLOCK; ++i)
+        {
+          const auto bit = i * width;
+          const auto shift = static_cast <unsigned>(bit % 64);
+          words[bit / 64] |= values[i] << shift;
+          if (shift + width > 64)
+          {
+            words[bit / 64 + 1] |= values[i] >> (64 - shift);
+          }
+        }
+        // stored as little-endian bytes whatever the byte order of the target
+        const auto bytes = reinterpret_cast <unsigned char *>(words);
+        for (unsigned i = 0; i < 2 * width; ++i)
+        {
+          const auto word = words[i];
+          for (unsigned byte = 0; byte < 8; ++byte)
+          {
+            bytes[i * 8 + byte] = static_cast <unsigned char>(word >> (byte * 8));
+          }
+        }
+      }
+
+      // number of significant bits
+      inline auto bit_width(std::uint64_t value) -> unsigned
+      {
+        auto width = 0u;
+        for (; value != 0; value >>= 1)
+        {
+          ++width;
+        }
+        return width;
+      }
+    }
+  }
+}
+
+// Read-mostly integer sequence compressed in blocks of 128 values.
+// Each block is stored either as deltas from its first value (blocks that never decrease : sorted ids, timestamps)
+// or as offsets from its minimum (small-range values), bit-packed with the smallest width that fits.
+// each / inject / select decode one block at a time into a local buffer, so scans read only the packed words.
+// The per-block headers act as skip pointers : operator [] touches a single block.
+// push_back appends to an uncompressed tail that is packed whenever it reaches a full block.
+template <class _T>
+class matsulib::PackedArray
+{
+  static_assert(std::is_integral <_T>::value && sizeof(_T) <= sizeof(std::uint64_t), "matsulib::PackedArray : _T must be an integer type !!");
+
+public:
+  using value_type = _T;
+  using size_type = std::size_t;
+  static constexpr size_type BLOCK = _detail::packed_array::BLOCK;
+
+protected:
+  using unsigned_type = typename std::make_unsigned <_T>::type;
+
+  // block header : where the block's words start and how to rebuild its values
+  struct Block
+  {
+  public:
+    std::uint64_t reference;
+    size_type offset;
+    unsigned char width;
+    bool delta;
+  };
+
+  Array <Block> _blocks;
+  // packed words of every block, followed by one padding word
+  Array <std::uint64_t> _words;
+  Array <_T> _tail;
+
+public:
+  PackedArray() : _words(1) {}
+  template <class _Iterator>
+  PackedArray(_Iterator first, _Iterator last) : PackedArray{}
+  {
+    for (; first != last; ++first)
+    {
+      push_back(*first);
+    }
+  }
+  PackedArray(std::initializer_list <_T> values) : PackedArray{ values.begin(), values.end() } {}
+  template <class _Allocator>
+  explicit PackedArray(const Array <_T, _Allocator> &values) : PackedArray{ values.begin(), values.end() } {}
+
+public:
+  auto size() const -> size_type { return _blocks.size() * BLOCK + _tail.size(); }
+  auto empty() const -> bool { return size() == 0; }
+  // bytes held by the compressed representation (headers, packed words and tail)
+  auto memory_usage() const -> size_type
+  {
+    return _blocks.size() * sizeof(Block) + _words.size() * sizeof(std::uint64_t) + _tail.size() * sizeof(_T);
+  }
+
+  auto operator [](size_type index) const -> _T
+  {
+    const auto block_index = index / BLOCK;
+    if (block_index == _blocks.size())
+    {
+      return _tail[index % BLOCK];
+    }
+    const auto &block = _blocks[block_index];
+    const auto words = _words.data() + block.offset;
+    auto value = static_cast <unsigned_type>(block.reference);
+    if (block.delta)
+    {
+      for (size_type i = 1; i <= index % BLOCK; ++i)
+      {
+        value += static_cast <unsigned_type>(_detail::packed_array::extract(words, block.width, i));
+      }
+    }
+    else
+    {
+      value += static_cast <unsigned_type>(_detail::packed_array::extract(words, block.width, index % BLOCK));
+    }
+    return static_cast <_T>(value);
+  }
+  auto at(size_type index) const -> _T
+  {
+    if (index >= size())
+    {
+      throw std::out_of_range{ "matsulib::PackedArray::at() : Out Of Range!!" };
+    }
+    return (*this)[index];
+  }
+
+  auto push_back(_T value) -> void
+  {
+    _tail.push_back(value);
+    if (_tail.size() == BLOCK)
+    {
+      pack_tail();
+    }
+  }
+  auto clear() -> void
+  {
+    _blocks.clear();
+    _words.assign(1, 0);
+    _tail.clear();
+  }
+  auto to_array() const -> Array <_T>
+  {
+    auto dst_array = Array <_T>{};
+    dst_array.reserve(size());
+    for_each_block([&dst_array](const _T *values, size_type count, size_type) { dst_array.insert(dst_array.end(), values, values + count); });
+    return dst_array;
+  }
+
+public:
+  template <class _Func>
+  auto each_with_index(_Func &&func) const -> const PackedArray &
+  {
+    for_each_block([&func](const _T *values, size_type count, size_type first)
+    {
+      for (size_type i = 0; i < count; ++i)
+      {
+        func(values[i], first + i);
+      }
+    });
+    return *this;
+  }
+  template <class _Func>
+  auto each(_Func &&func) const -> const PackedArray &
+  {
+    return each_with_index([&func](_T value, size_type) { func(value); });
+  }
+  // blocks are decoded independently, so each chunk of blocks runs on its own thread
+  template <class _Func>
+  auto each_with_index(const execution::ParallelPolicy &policy, _Func &&func) const -> const PackedArray &
+  {
+    parallel_blocks(policy, [&func](std::size_t, const _T *values, size_type count, size_type first)
+    {
+      for (size_type i = 0; i < count; ++i)
+      {
+        func(values[i], first + i);
+      }
+    });
+    return *this;
+  }
+  template <class _Func>
+  auto each(const execution::ParallelPolicy &policy, _Func &&func) const -> const PackedArray &
+  {
+    return each_with_index(policy, [&func](_T value, size_type) { func(value); });
+  }
+
+  template <class _Func>
+  auto select_with_index(_Func &&func) const -> Array <_T>
+  {
+    auto dst_array = Array <_T>{};
+    each_with_index([&](_T value, size_type index)
+    {
+      if (func(value, index))
+      {
+        dst_array.push_back(value);
+      }
+    });
+    return dst_array;
+  }
+  template <class _Func>
+  auto select(_Func &&func) const -> Array <_T>
+  {
+    return select_with_index([&func](_T value, size_type) { return func(value); });
+  }
+
+  template <class _DistType, class _Func>
+  auto inject(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _DistType
+  {
+    auto accumulation = std::move(initial_value);
+    for_each_block([&](const _T *values, size_type count, size_type)
+    {
+      for (size_type i = 0; i < count; ++i)
+      {
+        accumulation = func(std::move(accumulation), values[i]);
+      }
+    });
+    return accumulation;
+  }
+  template <class _Func>
+  auto inject(_T initial_value, _Func &&func) const -> _T
+  {
+    return inject <_T>(initial_value, std::forward <_Func>(func));
+  }
+  // every chunk of blocks is folded from initial_value, then the chunk results are folded by combine in order
+  template <class _DistType, class _Func, class _Combine>
+  auto inject(const execution::ParallelPolicy &policy, typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func, _Combine &&combine) const -> _DistType
+  {
+    const auto num_of_chunks = _detail::execution::num_of_chunks(policy, size());
+    auto partials = Array <_DistType>(num_of_chunks == 0 ? 1 : num_of_chunks, initial_value);
+    parallel_blocks(policy, [&](std::size_t chunk, const _T *values, size_type count, size_type)
+    {
+      auto &accumulation = partials[chunk];
+      for (size_type i = 0; i < count; ++i)
+      {
+        accumulation = func(std::move(accumulation), values[i]);
+      }
+    });
+    auto accumulation = std::move(partials[0]);
+    for (size_type i = 1; i < partials.size(); ++i)
+    {
+      accumulation = combine(std::move(accumulation), std::move(partials[i]));
+    }
+    return accumulation;
+  }
+  template <class _Func, class _Combine>
+  auto inject(const execution::ParallelPolicy &policy, _T initial_value, _Func &&func, _Combine &&combine) const -> _T
+  {
+    return inject <_T>(policy, initial_value, std::forward <_Func>(func), std::forward <_Combine>(combine));
+  }
+
+protected:
+  auto pack_tail() -> void
+  {
+    const auto first = static_cast <unsigned_type>(_tail[0]);
+    auto minimum = _tail[0];
+    auto ascending = true;
+    auto delta_bits = std::uint64_t(0);
+    for (size_type i = 1; i < BLOCK; ++i)
+    {
+      ascending = ascending && !(_tail[i] < _tail[i - 1]);
+      delta_bits |= static_cast <unsigned_type>(static_cast <unsigned_type>(_tail[i]) - static_cast <unsigned_type>(_tail[i - 1]));
+      minimum = _tail[i] < minimum ? _tail[i] : minimum;
+    }
+    auto offset_bits = std::uint64_t(0);
+    for (size_type i = 0; i < BLOCK; ++i)
+    {
+      offset_bits |= static_cast <unsigned_type>(static_cast <unsigned_type>(_tail[i]) - static_cast <unsigned_type>(minimum));
+    }
+    const auto offset_width = _detail::packed_array::bit_width(offset_bits);
+    const auto delta_width = _detail::packed_array::bit_width(delta_bits);
+    const auto delta = ascending && delta_width < offset_width;
+    const auto width = delta ? delta_width : offset_width;
+
+    std::uint64_t residuals[BLOCK];
+    const auto reference = delta ? first : static_cast <unsigned_type>(minimum);
+    for (size_type i = 0; i < BLOCK; ++i)
+    {
+      const auto base = delta ? (i == 0 ? first : static_cast <unsigned_type>(_tail[i - 1])) : reference;
+      residuals[i] = static_cast <unsigned_type>(static_cast <unsigned_type>(_tail[i]) - base);
+    }
+
+    // the padding word moves to the end again
+    const auto offset = _words.size() - 1;
+    _words.resize(offset + 2 * width + 1, 0);
+    _detail::packed_array::pack(residuals, width, _words.data() + offset);
+    _blocks.push_back(Block{ reference, offset, static_cast <unsigned char>(width), delta });
+    _tail.clear();
+  }
+
+  // values of block block_index into values [0, BLOCK)
+  auto decode(size_type block_index, _T *values) const -> void
+  {
+    const auto &block = _blocks[block_index];
+    std::uint64_t words[BLOCK];
+    _detail::packed_array::unpack(block.width, _words.data() + block.offset, block.delta, block.reference, words);
+    for (size_type i = 0; i < BLOCK; ++i)
+    {
+      values[i] = static_cast <_T>(static_cast <unsigned_type>(words[i]));
+    }
+  }
+  // func(values, count, index_of_values[0]) for every decoded block, then for the tail
+  template <class _Func>
+  auto for_each_block(_Func &&func) const -> void
+  {
+    _T values[BLOCK];
+    for (size_type block = 0; block < _blocks.size(); ++block)
+    {
+      decode(block, values);
+      func(static_cast <const _T *>(values), BLOCK, block * BLOCK);
+    }
+    if (!_tail.empty())
+    {
+      func(_tail.data(), _tail.size(), _blocks.size() * BLOCK);
+    }
+  }
+  // func(chunk_index, values, count, index_of_values[0]) ; the tail belongs to the last chunk
+  template <class _Func>
+  auto parallel_blocks(const execution::ParallelPolicy &policy, _Func &&func) const -> void
+  {
+    const auto num_of_blocks = _blocks.size();
+    const auto num_of_chunks = _detail::execution::num_of_chunks(policy, size());
+    _detail::execution::run_chunks(num_of_chunks, num_of_blocks, [&](std::size_t chunk, size_type begin, size_type end)
+    {
+      _T values[BLOCK];
+      for (auto block = begin; block < end; ++block)
+      {
+        decode(block, values);
+        func(chunk, static_cast <const _T *>(values), BLOCK, block * BLOCK);
+      }
+      if (chunk + 1 == num_of_chunks && !_tail.empty())
+      {
+        func(chunk, _tail.data(), _tail.size(), num_of_blocks * BLOCK);
+      }
+    });
+  }
+};
+
+template <class _T>
+constexpr typename matsulib::PackedArray <_T>::size_type matsulib::PackedArray <_T>::BLOCK;
@@ -0,0 +1,389 @@
+﻿#pragma once
+
+#include <cstddef>
+
+namespace matsulib
+{
+  template <class _T> class PersistentArray;
+}
+
+#include "array.hpp"
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace matsulib
+{
+  namespace _detail
+  {
+    namespace persistent_array
+    {
+      constexpr std::size_t BITS = 5;
+      constexpr std::size_t WIDTH = std::size_t(1) << BITS;
+      constexpr std::size_t MASK = WIDTH - 1;
+
+      // Leaves hold up to WIDTH values, branches up to WIDTH children. Nodes are never modified once shared.
+      template <class _T>
+      struct Node
+      {
+      public:
+        std::vector <std::shared_ptr <const Node>> children;
+        std::vector <_T> values;
+      };
+
+      // Collects values into full leaves; the last (partial) leaf becomes the tail.
+      template <class _T>
+      class Builder
+      {
+      public:
+        using node_type = Node <_T>;
+        using node_pointer = std::shared_ptr <const node_type>;
+
+      protected:
+        std::vector <node_pointer> _leaves;
+        std::shared_ptr <node_type> _leaf;
+        std::size_t _size = 0;
+
+      public:
+        template <class ..._Args>
+        auto emplace_back(_Args &&...args) -> void
+        {
+          if (!_leaf || _leaf->values.size() == WIDTH)
+          {
+            if (_leaf)
+            {
+              _leaves.push_back(std::move(_leaf));
+            }
+            _leaf = std::make_shared <node_type>();
+            _leaf->values.reserve(WIDTH);
+          }
+          _leaf->values.emplace_back(std::forward <_Args>(args)...);
+          ++_size;
+        }
+        // root and tail of the trie (the tail is null when nothing was added)
+        auto build(node_pointer &root, node_pointer &tail, std::size_t &shift, std::size_t &size) -> void
+        {
+          auto nodes = std::move(_leaves);
+          shift = BITS;
+          while (nodes.size() > WIDTH)
+          {
+            auto parents = std::vector <node_pointer>{};
+            for (std::size_t i = 0; i < nodes.size(); i += WIDTH)
+            {
+              auto parent = std::make_shared <node_type>();
+              const auto last = i + WIDTH < nodes.size() ? i + WIDTH : nodes.size();
+              parent->children.assign(nodes.begin() + i, nodes.begin() + last);
+              parents.push_back(std::move(parent));
+            }
+            nodes.swap(parents);
+            shift += BITS;
+          }
+          auto top = std::make_shared <node_type>();
+          top->children = std::move(nodes);
+          root = std::move(top);
+          tail = std::move(_leaf);
+          size = _size;
+        }
+      };
+    }
+  }
+}
+
+// Immutable sequence with structural sharing (a 32-way trie of leaves plus a tail leaf, as in Clojure's vector).
+// Copies share every node (O(1)); set / push_back return a new version copying only the path to one leaf (O(log32 n))
+// and leave this one untouched, so old versions remain valid snapshots. Shared nodes are never written,
+// so versions can be read from several threads.
+template <class _T>
+class matsulib::PersistentArray
+{
+  template <class> friend class matsulib::PersistentArray;
+
+public:
+  using value_type = _T;
+  using size_type = std::size_t;
+
+protected:
+  using node_type = _detail::persistent_array::Node <_T>;
+  using node_pointer = std::shared_ptr <const node_type>;
+
+  node_pointer _root;
+  node_pointer _tail;
+  size_type _shift;
+  size_type _size;
+
+public:
+  PersistentArray() : _root{ std::make_shared <node_type>() }, _tail{}, _shift{ _detail::persistent_array::BITS }, _size{ 0 } {}
+  PersistentArray(std::initializer_list <_T> values) : PersistentArray(values.begin(), values.end()) {}
+  template <class _Allocator>
+  explicit PersistentArray(const Array <_T, _Allocator> &values) : PersistentArray(values.begin(), values.end()) {}
+  template <class _Iterator>
+  PersistentArray(_Iterator first, _Iterator last) : PersistentArray{}
+  {
+    auto builder = _detail::persistent_array::Builder <_T>{};
+    for (; first != last; ++first)
+    {
+      builder.emplace_back(*first);
+    }
+    builder.build(_root, _tail, _shift, _size);
+  }
+
+public:
+  auto size() const -> size_type { return _size; }
+  auto empty() const -> bool { return _size == 0; }
+
+  auto operator [](size_type index) const -> const _T & { return leaf_for(index)->values[index & _detail::persistent_array::MASK]; }
+  auto at(size_type index) const -> const _T &
+  {
+    if (index >= _size)
+    {
+      throw std::out_of_range{ "matsulib::PersistentArray::at() : Out Of Range!!" };
+    }
+    return (*this)[index];
+  }
+  auto front() const -> const _T & { return (*this)[0]; }
+  auto back() const -> const _T & { return (*this)[_size - 1]; }
+
+  // new version with the index-th element replaced
+  auto set(size_type index, _T value) const -> PersistentArray
+  {
+    if (index >= _size)
+    {
+      throw std::out_of_range{ "matsulib::PersistentArray::set() : Out Of Range!!" };
+    }
+    auto dst = *this;
+    if (index >= tail_offset())
+    {
+      auto tail = std::make_shared <node_type>(*_tail);
+      tail->values[index & _detail::persistent_array::MASK] = std::move(value);
+      dst._tail = std::move(tail);
+    }
+    else
+    {
+      dst._root = set_path(*_root, _shift, index, std::move(value));
+    }
+    return dst;
+  }
+  // new version with value appended
+  auto push_back(_T value) const -> PersistentArray
+  {
+    using namespace _detail::persistent_array;
+    auto dst = *this;
+    if (_tail && _tail->values.size() < WIDTH)
+    {
+      auto tail = std::make_shared <node_type>(*_tail);
+      tail->values.push_back(std::move(value));
+      dst._tail = std::move(tail);
+    }
+    else
+    {
+      if (_tail)
+      {
+        // the full tail moves into the trie, which grows a level when it is full
+        if ((_size >> BITS) > (size_type(1) << _shift))
+        {
+          auto root = std::make_shared <node_type>();
+          root->children.push_back(_root);
+          root->children.push_back(new_path(_shift, _tail));
+          dst._root = std::move(root);
+          dst._shift = _shift + BITS;
+        }
+        else
+        {
+          dst._root = push_tail(*_root, _shift, _tail);
+        }
+      }
+      auto tail = std::make_shared <node_type>();
+      tail->values.reserve(WIDTH);
+      tail->values.push_back(std::move(value));
+      dst._tail = std::move(tail);
+    }
+    ++dst._size;
+    return dst;
+  }
+
+  auto to_array() const -> Array <_T>
+  {
+    auto dst_array = Array <_T>{};
+    dst_array.reserve(_size);
+    each([&dst_array](const _T &value) { dst_array.push_back(value); });
+    return dst_array;
+  }
+
+public:
+  // visits leaf by leaf : one trie descent per 32 elements
+  template <class _Func>
+  auto each_with_index(_Func &&func) const -> const PersistentArray &
+  {
+    for (size_type begin = 0; begin < _size; begin += _detail::persistent_array::WIDTH)
+    {
+      const auto &values = leaf_for(begin)->values;
+      for (size_type i = 0; i < values.size(); ++i)
+      {
+        func(static_cast <const _T &>(values[i]), begin + i);
+      }
+    }
+    return *this;
+  }
+  template <class _Func>
+  auto each(_Func &&func) const -> const PersistentArray &
+  {
+    return each_with_index([&func](const _T &value, size_type) { func(value); });
+  }
+
+  template <class _Func>
+  auto select_with_index(_Func &&func) const -> PersistentArray
+  {
+    auto builder = _detail::persistent_array::Builder <_T>{};
+    each_with_index([&](const _T &value, size_type index)
+    {
+      if (func(value, index))
+      {
+        builder.emplace_back(value);
+      }
+    });
+    return PersistentArray{ builder };
+  }
+  template <class _Func>
+  auto select(_Func &&func) const -> PersistentArray
+  {
+    return select_with_index([&func](const _T &value, size_type) { return func(value); });
+  }
+
+  template <class _DistType, class _Func>
+  auto map_with_index(_Func &&func) const -> PersistentArray <_DistType>
+  {
+    auto builder = _detail::persistent_array::Builder <_DistType>{};
+    each_with_index([&](const _T &value, size_type index) { builder.emplace_back(func(value, index)); });
+    return PersistentArray <_DistType>{ builder };
+  }
+  template <class _Func>
+  auto map_with_index(_Func &&func) const -> PersistentArray
+  {
+    return map_with_index <_T>(std::forward <_Func>(func));
+  }
+  template <class _DistType, class _Func>
+  auto map(_Func &&func) const -> PersistentArray <_DistType>
+  {
+    return map_with_index <_DistType>([&func](const _T &value, size_type) { return func(value); });
+  }
+  template <class _Func>
+  auto map(_Func &&func) const -> PersistentArray
+  {
+    return map <_T>(std::forward <_Func>(func));
+  }
+
+  template <class _DistType, class _Func>
+  auto inject_with_index(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _DistType
+  {
+    auto accumulation = std::move(initial_value);
+    each_with_index([&](const _T &value, size_type index) { accumulation = func(std::move(accumulation), value, index); });
+    return accumulation;
+  }
+  template <class _Func>
+  auto inject_with_index(_T initial_value, _Func &&func) const -> _T
+  {
+    return inject_with_index <_T>(std::move(initial_value), std::forward <_Func>(func));
+  }
+  template <class _DistType, class _Func>
+  auto inject(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _DistType
+  {
+    return inject_with_index <_DistType>(std::move(initial_value), [&func](_DistType accumulation, const _T &value, size_type) { return func(std::move(accumulation), value); });
+  }
+  template <class _Func>
+  auto inject(_T initial_value, _Func &&func) const -> _T
+  {
+    return inject <_T>(std::move(initial_value), std::forward <_Func>(func));
+  }
+  template <class _DistType, class _Func>
+  auto inject(_Func &&func) const -> _DistType
+  {
+    return inject <_DistType>(_DistType{}, std::forward <_Func>(func));
+  }
+  template <class _Func>
+  auto inject(_Func &&func) const -> _T
+  {
+    return inject <_T>(_T{}, std::forward <_Func>(func));
+  }
+
+protected:
+  explicit PersistentArray(_detail::persistent_array::Builder <_T> &builder) : PersistentArray{}
+  {
+    builder.build(_root, _tail, _shift, _size);
+  }
+
+  // the tail holds [tail_offset(), size())
+  auto tail_offset() const -> size_type
+  {
+    return _size == 0 ? 0 : ((_size - 1) >> _detail::persistent_array::BITS) << _detail::persistent_array::BITS;
+  }
+  auto leaf_for(size_type index) const -> const node_type *
+  {
+    using namespace _detail::persistent_array;
+    if (index >= tail_offset())
+    {
+      return _tail.get();
+    }
+    auto node = _root.get();
+    for (auto level = _shift; level > 0; level -= BITS)
+    {
+      node = node->children[(index >> level) & MASK].get();
+    }
+    return node;
+  }
+  auto set_path(const node_type &node, size_type level, size_type index, _T &&value) const -> node_pointer
+  {
+    using namespace _detail::persistent_array;
+    auto copy = std::make_shared <node_type>(node);
+    if (level == 0)
+    {
+      copy->values[index & MASK] = std::move(value);
+    }
+    else
+    {
+      const auto child = (index >> level) & MASK;
+      copy->children[child] = set_path(*node.children[child], level - BITS, index, std::move(value));
+    }
+    return copy;
+  }
+  // copy of parent with leaf appended at the position of the last _size elements' leaf (the current tail)
+  auto push_tail(const node_type &parent, size_type level, const node_pointer &leaf) const -> node_pointer
+  {
+    using namespace _detail::persistent_array;
+    auto copy = std::make_shared <node_type>(parent);
+    const auto child = ((_size - 1) >> level) & MASK;
+    auto inserted = node_pointer{};
+    if (level == BITS)
+    {
+      inserted = leaf;
+    }
+    else if (child < parent.children.size())
+    {
+      inserted = push_tail(*parent.children[child], level - BITS, leaf);
+    }
+    else
+    {
+      inserted = new_path(level - BITS, leaf);
+    }
+    if (child < copy->children.size())
+    {
+      copy->children[child] = std::move(inserted);
+    }
+    else
+    {
+      copy->children.push_back(std::move(inserted));
+    }
+    return copy;
+  }
+  static auto new_path(size_type level, const node_pointer &leaf) -> node_pointer
+  {
+    if (level == 0)
+    {
+      return leaf;
+    }
+    auto node = std::make_shared <node_type>();
+    node->children.push_back(new_path(level - _detail::persistent_array::BITS, leaf));
+    return node;
+  }
+};
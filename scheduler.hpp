@@ -0,0 +1,392 @@
+﻿#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace matsulib
+{
+  namespace execution
+  {
+    struct SchedulerConfig
+    {
+    public:
+      // threads running tasks, the calling thread included (0 : hardware concurrency)
+      std::size_t num_of_threads = 0;
+      // binds worker k to core k (the calling thread is left alone)
+      bool pin_threads = false;
+    };
+
+    class Scheduler;
+  }
+
+  namespace _detail
+  {
+    namespace scheduler
+    {
+      using Swallow = int[];
+
+      struct TaskGroup
+      {
+      public:
+        std::atomic <std::size_t> pending{ 0 };
+        std::atomic <bool> failed{ false };
+        std::exception_ptr error;
+      };
+
+      // invoke(task) runs [begin, end) of the job behind context; tasks are copied by value into the queues.
+      struct Task
+      {
+      public:
+        void (*invoke)(Task &task);
+        void *context;
+        std::size_t begin;
+        std::size_t end;
+        TaskGroup *group;
+      };
+
+      // The owner pushes and pops at the back (newest, still in cache), thieves take from the front (oldest, largest ranges).
+      class WorkQueue
+      {
+      protected:
+        std::mutex _mutex;
+        std::deque <Task> _tasks;
+
+      public:
+        auto push(const Task &task) -> void
+        {
+          std::lock_guard <std::mutex> lock{ _mutex };
+          _tasks.push_back(task);
+        }
+        auto pop(Task &task) -> bool
+        {
+          std::lock_guard <std::mutex> lock{ _mutex };
+          if (_tasks.empty())
+          {
+            return false;
+          }
+          task = _tasks.back();
+          _tasks.pop_back();
+          return true;
+        }
+        auto steal(Task &task) -> bool
+        {
+          std::lock_guard <std::mutex> lock{ _mutex };
+          if (_tasks.empty())
+          {
+            return false;
+          }
+          task = _tasks.front();
+          _tasks.pop_front();
+          return true;
+        }
+      };
+
+      // index of the calling thread among the workers, npos for any other thread
+      constexpr std::size_t NOT_WORKER = static_cast <std::size_t>(-1);
+      inline auto worker_index() -> std::size_t &
+      {
+        static thread_local std::size_t index = NOT_WORKER;
+        return index;
+      }
+
+      inline auto pin(std::thread &thread, std::size_t core) -> void
+      {
+#if defined(_WIN32)
+        if (core < sizeof(DWORD_PTR) * 8)
+        {
+          SetThreadAffinityMask(thread.native_handle(), static_cast <DWORD_PTR>(1) << core);
+        }
+#elif defined(__linux__)
+        auto cores = cpu_set_t{};
+        CPU_ZERO(&cores);
+        CPU_SET(core, &cores);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(cores), &cores);
+#else
+        (void)thread;
+        (void)core;
+#endif
+      }
+
+      template <class _Func>
+      struct RangeJob
+      {
+      public:
+        matsulib::execution::Scheduler *scheduler;
+        _Func *func;
+        std::size_t grain_size;
+      };
+    }
+  }
+}
+
+// Work-stealing thread pool shared by the parallel (par) operations of matsulib.
+// It is created on first use with the configuration given to configure(), so code that never runs in parallel starts no thread.
+// Every worker owns a queue; idle workers steal from the others and a thread waiting for its tasks runs queued tasks meanwhile,
+// so nested parallel calls (a parallel map whose elements run parallel kernels) share the same threads instead of adding more.
+class matsulib::execution::Scheduler
+{
+protected:
+  using Task = _detail::scheduler::Task;
+  using TaskGroup = _detail::scheduler::TaskGroup;
+  using WorkQueue = _detail::scheduler::WorkQueue;
+
+  std::size_t _num_of_threads;
+  // _num_of_threads - 1 : the thread waiting for its tasks works as well
+  std::size_t _num_of_workers;
+  // one queue per worker, then the queue shared by all other threads
+  std::vector <std::unique_ptr <WorkQueue>> _queues;
+  std::vector <std::thread> _workers;
+  std::mutex _sleep_mutex;
+  std::condition_variable _wake;
+  std::atomic <std::size_t> _epoch{ 0 };
+  std::atomic <std::size_t> _sleeping{ 0 };
+  std::atomic <bool> _stop{ false };
+
+public:
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator =(const Scheduler &) = delete;
+  ~Scheduler()
+  {
+    {
+      std::lock_guard <std::mutex> lock{ _sleep_mutex };
+      _stop = true;
+    }
+    _wake.notify_all();
+    for (auto &worker : _workers)
+    {
+      worker.join();
+    }
+  }
+
+public:
+  // Must be called before the first parallel operation.
+  static auto configure(const SchedulerConfig &config) -> void
+  {
+    if (started())
+    {
+      throw std::logic_error{ "matsulib::execution::Scheduler::configure() : Already Started!!" };
+    }
+    configuration() = config;
+  }
+  static auto instance() -> Scheduler &
+  {
+    static Scheduler scheduler{ configuration() };
+    started() = true;
+    return scheduler;
+  }
+  // threads the scheduler runs (or will run) tasks on, without starting it
+  static auto concurrency() -> std::size_t
+  {
+    return resolve(configuration().num_of_threads);
+  }
+
+  auto num_of_threads() const -> std::size_t { return _num_of_threads; }
+
+  // func(begin, end) over pieces of [begin, end) no longer than grain_size, split in halves on demand
+  template <class _Func>
+  auto parallel_for(std::size_t begin, std::size_t end, std::size_t grain_size, _Func &&func) -> void
+  {
+    using func_type = typename std::remove_reference <_Func>::type;
+    grain_size = grain_size == 0 ? 1 : grain_size;
+    if (end <= begin)
+    {
+      return;
+    }
+    if (_num_of_workers == 0 || end - begin <= grain_size)
+    {
+      func(begin, end);
+      return;
+    }
+    TaskGroup group;
+    auto job = _detail::scheduler::RangeJob <func_type>{ this, &func, grain_size };
+    auto root = Task{ &run_range <func_type>, &job, begin, end, &group };
+    execute(root);
+    wait(group);
+  }
+
+  // runs every func, possibly at the same time, and returns when all of them have finished
+  template <class _First, class ..._Rest>
+  auto parallel_invoke(_First &&first, _Rest &&...rest) -> void
+  {
+    if (_num_of_workers == 0)
+    {
+      first();
+      (void)_detail::scheduler::Swallow{ 0, (rest(), 0)... };
+      return;
+    }
+    TaskGroup group;
+    (void)_detail::scheduler::Swallow{ 0, (spawn(Task{ &run_callable <typename std::remove_reference <_Rest>::type>, const_cast <void *>(static_cast <const void *>(&rest)), 0, 0, &group }), 0)... };
+    auto task = Task{ &run_callable <typename std::remove_reference <_First>::type>, const_cast <void *>(static_cast <const void *>(&first)), 0, 0, &group };
+    execute(task);
+    wait(group);
+  }
+
+protected:
+  explicit Scheduler(const SchedulerConfig &config) : _num_of_threads{ resolve(config.num_of_threads) }, _num_of_workers{ _num_of_threads - 1 }
+  {
+    for (std::size_t index = 0; index <= _num_of_workers; ++index)
+    {
+      _queues.emplace_back(new WorkQueue{});
+    }
+    _workers.reserve(_num_of_workers);
+    const auto num_of_cores = resolve(0);
+    for (std::size_t index = 0; index < _num_of_workers; ++index)
+    {
+      _workers.emplace_back([this, index] { work(index); });
+      if (config.pin_threads)
+      {
+        _detail::scheduler::pin(_workers.back(), (index + 1) % num_of_cores);
+      }
+    }
+  }
+
+  static auto configuration() -> SchedulerConfig &
+  {
+    static auto config = SchedulerConfig{};
+    return config;
+  }
+  static auto started() -> std::atomic <bool> &
+  {
+    static std::atomic <bool> flag{ false };
+    return flag;
+  }
+  static auto resolve(std::size_t num_of_threads) -> std::size_t
+  {
+    if (num_of_threads != 0)
+    {
+      return num_of_threads;
+    }
+    const auto hardware = std::thread::hardware_concurrency();
+    return hardware == 0 ? 1 : static_cast <std::size_t>(hardware);
+  }
+
+  template <class _Func>
+  static auto run_range(Task &task) -> void
+  {
+    const auto &job = *static_cast <const _detail::scheduler::RangeJob <_Func> *>(task.context);
+    auto end = task.end;
+    while (end - task.begin > job.grain_size)
+    {
+      const auto middle = task.begin + (end - task.begin) / 2;
+      job.scheduler->spawn(Task{ task.invoke, task.context, middle, end, task.group });
+      end = middle;
+    }
+    (*job.func)(task.begin, end);
+  }
+  template <class _Func>
+  static auto run_callable(Task &task) -> void
+  {
+    (*static_cast <_Func *>(task.context))();
+  }
+
+  // tasks of a group that has already failed are skipped; the first exception is kept for wait()
+  static auto execute(Task &task) -> void
+  {
+    if (task.group->failed.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+    try
+    {
+      task.invoke(task);
+    }
+    catch (...)
+    {
+      if (!task.group->failed.exchange(true))
+      {
+        task.group->error = std::current_exception();
+      }
+    }
+  }
+
+  auto spawn(const Task &task) -> void
+  {
+    task.group->pending.fetch_add(1, std::memory_order_relaxed);
+    const auto self = _detail::scheduler::worker_index();
+    _queues[self < _num_of_workers ? self : _num_of_workers]->push(task);
+    _epoch.fetch_add(1);
+    if (_sleeping.load() != 0)
+    {
+      std::lock_guard <std::mutex> lock{ _sleep_mutex };
+      _wake.notify_one();
+    }
+  }
+
+  // own queue first, then the shared queue, then the other workers
+  auto try_run_one() -> bool
+  {
+    const auto self = _detail::scheduler::worker_index();
+    auto task = Task{};
+    auto found = self < _num_of_workers && _queues[self]->pop(task);
+    found = found || _queues[_num_of_workers]->steal(task);
+    for (std::size_t offset = 1; !found && offset <= _num_of_workers; ++offset)
+    {
+      const auto victim = ((self < _num_of_workers ? self : 0) + offset) % _num_of_workers;
+      found = _queues[victim]->steal(task);
+    }
+    if (!found)
+    {
+      return false;
+    }
+    const auto group = task.group;
+    execute(task);
+    group->pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+  }
+
+  // helps with queued tasks until every task of group has finished
+  auto wait(TaskGroup &group) -> void
+  {
+    while (group.pending.load(std::memory_order_acquire) != 0)
+    {
+      if (!try_run_one())
+      {
+        std::this_thread::yield();
+      }
+    }
+    if (group.error)
+    {
+      std::rethrow_exception(group.error);
+    }
+  }
+
+  auto work(std::size_t index) -> void
+  {
+    _detail::scheduler::worker_index() = index;
+    while (!_stop.load())
+    {
+      const auto epoch = _epoch.load();
+      if (try_run_one())
+      {
+        continue;
+      }
+      std::unique_lock <std::mutex> lock{ _sleep_mutex };
+      ++_sleeping;
+      _wake.wait(lock, [&] { return _stop.load() || _epoch.load() != epoch; });
+      --_sleeping;
+    }
+  }
+};
@@ -0,0 +1,570 @@
+﻿#pragma once
+
+#include "index_range.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MATSULIB_SIMD_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MATSULIB_SIMD_TARGET_SSE2
+#define MATSULIB_SIMD_TARGET_AVX2
+#else
+#define MATSULIB_SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define MATSULIB_SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace matsulib
+{
+  namespace simd
+  {
+    enum class Isa : int
+    {
+      SCALAR = 0,
+      SSE2 = 1,
+      AVX2 = 2
+    };
+
+    // Predicate of Array::count_if(compare, value) : element <compare> value
+    enum class Compare : int
+    {
+      EQUAL = 0,
+      NOT_EQUAL = 1,
+      LESS = 2,
+      LESS_EQUAL = 3,
+      GREATER = 4,
+      GREATER_EQUAL = 5
+    };
+
+    // Accumulation type of sum() / dot() : integers are widened to 64 bit.
+    template <class _T>
+    struct SumType
+    {
+      using type = typename std::conditional <!std::is_integral <_T>::value, _T,
+        typename std::conditional <std::is_signed <_T>::value, long long, unsigned long long>::type>::type;
+    };
+
+    // Best instruction set of the running CPU, detected once.
+    inline auto isa() -> Isa
+    {
+#if defined(MATSULIB_SIMD_X86)
+      static const auto detected = []
+      {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const auto max_leaf = info[0];
+        __cpuid(info, 1);
+        const auto os_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        auto avx2 = false;
+        if (os_avx && max_leaf >= 7)
+        {
+          __cpuidex(info, 7, 0);
+          avx2 = (info[1] & (1 << 5)) != 0;
+        }
+        return avx2 ? Isa::AVX2 : Isa::SSE2;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+          return Isa::AVX2;
+        }
+        return __builtin_cpu_supports("sse2") ? Isa::SSE2 : Isa::SCALAR;
+#endif
+      }();
+      return detected;
+#else
+      return Isa::SCALAR;
+#endif
+    }
+  }
+
+  namespace _detail
+  {
+    namespace simd
+    {
+      using matsulib::simd::Compare;
+      using matsulib::simd::Isa;
+      using matsulib::simd::SumType;
+
+      template <class _T>
+      inline auto matches(Compare compare, const _T &lhs, const _T &rhs) -> bool
+      {
+        switch (compare)
+        {
+        case Compare::EQUAL:         return lhs == rhs;
+        case Compare::NOT_EQUAL:     return lhs != rhs;
+        case Compare::LESS:          return lhs < rhs;
+        case Compare::LESS_EQUAL:    return lhs <= rhs;
+        case Compare::GREATER:       return lhs > rhs;
+        case Compare::GREATER_EQUAL: return lhs >= rhs;
+        }
+        return false;
+      }
+
+      // NaN rule shared by the scalar and vector kernels : min_max skips NaN elements (NaN only when every element is NaN),
+      // clamp turns NaN into low. Types other than floating point never hold NaN.
+      template <class _T>
+      inline auto is_nan(const _T &value) -> typename std::enable_if <std::is_floating_point <_T>::value, bool>::type { return value != value; }
+      template <class _T>
+      inline auto is_nan(const _T &) -> typename std::enable_if <!std::is_floating_point <_T>::value, bool>::type { return false; }
+      // first element that is not NaN (the last one when all are NaN) : the seed of min_max
+      template <class _T>
+      inline auto first_ordered(const _T *data, std::size_t length) -> std::size_t
+      {
+        std::size_t index = 0;
+        while (index + 1 < length && is_nan(data[index]))
+        {
+          ++index;
+        }
+        return index;
+      }
+
+      inline auto popcount(unsigned int bits) -> std::size_t
+      {
+        bits = bits - ((bits >> 1) & 0x55555555u);
+        bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+        bits = (bits + (bits >> 4)) & 0x0F0F0F0Fu;
+        return static_cast <std::size_t>((bits * 0x01010101u) >> 24);
+      }
+
+      // Plain loops : used for every other element type and when no vector unit is available.
+      template <class _T>
+      struct Scalar
+      {
+      public:
+        using sum_type = typename SumType <_T>::type;
+
+        static auto sum(const _T *data, std::size_t length) -> sum_type
+        {
+          auto result = sum_type{};
+          for (std::size_t i = 0; i < length; ++i)
+          {
+            result += data[i];
+          }
+          return result;
+        }
+        static auto dot(const _T *lhs, const _T *rhs, std::size_t length) -> sum_type
+        {
+          auto result = sum_type{};
+          for (std::size_t i = 0; i < length; ++i)
+          {
+            result += static_cast <sum_type>(lhs[i]) * static_cast <sum_type>(rhs[i]);
+          }
+          return result;
+        }
+        static auto min_max(const _T *data, std::size_t length, _T &min_value, _T &max_value) -> void
+        {
+          min_value = max_value = data[first_ordered(data, length)];
+          for (std::size_t i = 0; i < length; ++i)
+          {
+            min_value = data[i] < min_value ? data[i] : min_value;
+            max_value = max_value < data[i] ? data[i] : max_value;
+          }
+        }
+        static auto add(_T *dst, const _T *src, std::size_t length) -> void
+        {
+          for (std::size_t i = 0; i < length; ++i)
+          {
+            dst[i] = static_cast <_T>(dst[i] + src[i]);
+          }
+        }
+        static auto mul(_T *dst, const _T *src, std::size_t length) -> void
+        {
+          for (std::size_t i = 0; i < length; ++i)
+          {
+            dst[i] = static_cast <_T>(dst[i] * src[i]);
+          }
+        }
+        static auto scale(_T *dst, _T factor, std::size_t length) -> void
+        {
+          for (std::size_t i = 0; i < length; ++i)
+          {
+            dst[i] = static_cast <_T>(dst[i] * factor);
+          }
+        }
+        static auto clamp(_T *dst, _T low, _T high, std::size_t length) -> void
+        {
+          for (std::size_t i = 0; i < length; ++i)
+          {
+            // max(value, low) then min(value, high), in the operand order of _mm_max_ps / _mm_min_ps
+            const auto value = low < dst[i] ? dst[i] : low;
+            dst[i] = value < high ? value : high;
+          }
+        }
+        static auto count(const _T *data, std::size_t length, Compare compare, _T value) -> std::size_t
+        {
+          std::size_t result = 0;
+          for (std::size_t i = 0; i < length; ++i)
+          {
+            result += matches(compare, data[i], value) ? 1 : 0;
+          }
+          return result;
+        }
+      };
+
+      template <class _T>
+      struct Kernels : public Scalar <_T> {};
+
+#if defined(MATSULIB_SIMD_X86)
+      // Vector traits : one struct per (instruction set, element type).
+      struct Sse2F32
+      {
+      public:
+        using value_type = float;
+        using sum_type = float;
+        using vector = __m128;
+        using accumulator = __m128;
+        static constexpr std::size_t lanes = 4;
+
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto load(const float *data) -> __m128 { return _mm_loadu_ps(data); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto store(float *data, __m128 v) -> void { _mm_storeu_ps(data, v); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto set1(float value) -> __m128 { return _mm_set1_ps(value); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto add(__m128 a, __m128 b) -> __m128 { return _mm_add_ps(a, b); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto mul(__m128 a, __m128 b) -> __m128 { return _mm_mul_ps(a, b); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto min(__m128 a, __m128 b) -> __m128 { return _mm_min_ps(a, b); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto max(__m128 a, __m128 b) -> __m128 { return _mm_max_ps(a, b); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto count_eq(__m128 a, __m128 b) -> std::size_t { return popcount(_mm_movemask_ps(_mm_cmpeq_ps(a, b))); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto count_lt(__m128 a, __m128 b) -> std::size_t { return popcount(_mm_movemask_ps(_mm_cmplt_ps(a, b))); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto count_le(__m128 a, __m128 b) -> std::size_t { return popcount(_mm_movemask_ps(_mm_cmple_ps(a, b))); }
+
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_zero() -> __m128 { return _mm_setzero_ps(); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_add(__m128 acc, __m128 v) -> __m128 { return _mm_add_ps(acc, v); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_dot(__m128 acc, __m128 a, __m128 b) -> __m128 { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_reduce(__m128 acc) -> float
+        {
+          float lanes_of_acc[4];
+          _mm_storeu_ps(lanes_of_acc, acc);
+          return (lanes_of_acc[0] + lanes_of_acc[1]) + (lanes_of_acc[2] + lanes_of_acc[3]);
+        }
+      };
+
+      struct Sse2I32
+      {
+      public:
+        using value_type = std::int32_t;
+        using sum_type = typename SumType <std::int32_t>::type;
+        using vector = __m128i;
+        using accumulator = __m128i;
+        static constexpr std::size_t lanes = 4;
+
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto load(const std::int32_t *data) -> __m128i { return _mm_loadu_si128(reinterpret_cast <const __m128i *>(data)); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto store(std::int32_t *data, __m128i v) -> void { _mm_storeu_si128(reinterpret_cast <__m128i *>(data), v); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto set1(std::int32_t value) -> __m128i { return _mm_set1_epi32(value); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto add(__m128i a, __m128i b) -> __m128i { return _mm_add_epi32(a, b); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto mul(__m128i a, __m128i b) -> __m128i
+        {
+          // SSE2 has no 32 bit mullo : multiply even and odd lanes to 64 bit and gather the low halves
+          const auto even = _mm_mul_epu32(a, b);
+          const auto odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+          return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+        }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto min(__m128i a, __m128i b) -> __m128i
+        {
+          const auto greater = _mm_cmpgt_epi32(a, b);
+          return _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a));
+        }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto max(__m128i a, __m128i b) -> __m128i
+        {
+          const auto greater = _mm_cmpgt_epi32(a, b);
+          return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+        }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto count_eq(__m128i a, __m128i b) -> std::size_t { return popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)))); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto count_lt(__m128i a, __m128i b) -> std::size_t { return popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(a, b)))); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto count_le(__m128i a, __m128i b) -> std::size_t { return lanes - count_lt(b, a); }
+
+        // signed 32 x 32 -> 64 bit product of lanes 0 and 2 (SSE2 only has the unsigned one)
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto mul_even(__m128i a, __m128i b) -> __m128i
+        {
+          const auto product = _mm_mul_epu32(a, b);
+          const auto correction = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b), _mm_and_si128(_mm_srai_epi32(b, 31), a));
+          return _mm_sub_epi64(product, _mm_slli_epi64(correction, 32));
+        }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_zero() -> __m128i { return _mm_setzero_si128(); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_add(__m128i acc, __m128i v) -> __m128i
+        {
+          const auto sign = _mm_srai_epi32(v, 31);
+          return _mm_add_epi64(acc, _mm_add_epi64(_mm_unpacklo_epi32(v, sign), _mm_unpackhi_epi32(v, sign)));
+        }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_dot(__m128i acc, __m128i a, __m128i b) -> __m128i
+        {
+          return _mm_add_epi64(acc, _mm_add_epi64(mul_even(a, b), mul_even(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32))));
+        }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_reduce(__m128i acc) -> sum_type
+        {
+          long long lanes_of_acc[2];
+          _mm_storeu_si128(reinterpret_cast <__m128i *>(lanes_of_acc), acc);
+          return lanes_of_acc[0] + lanes_of_acc[1];
+        }
+      };
+
+      struct Sse2U8
+      {
+      public:
+        using value_type = std::uint8_t;
+        using sum_type = typename SumType <std::uint8_t>::type;
+        using vector = __m128i;
+        using accumulator = __m128i;
+        static constexpr std::size_t lanes = 16;
+
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto load(const std::uint8_t *data) -> __m128i { return _mm_loadu_si128(reinterpret_cast <const __m128i *>(data)); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto store(std::uint8_t *data, __m128i v) -> void { _mm_storeu_si128(reinterpret_cast <__m128i *>(data), v); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto set1(std::uint8_t value) -> __m128i { return _mm_set1_epi8(static_cast <char>(value)); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto add(__m128i a, __m128i b) -> __m128i { return _mm_add_epi8(a, b); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto mul(__m128i a, __m128i b) -> __m128i
+        {
+          // no 8 bit multiply : widen to 16 bit, multiply and pack the low bytes back
+          const auto zero = _mm_setzero_si128();
+          const auto low_byte = _mm_set1_epi16(0xFF);
+          const auto lo = _mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+          const auto hi = _mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+          return _mm_packus_epi16(_mm_and_si128(lo, low_byte), _mm_and_si128(hi, low_byte));
+        }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto min(__m128i a, __m128i b) -> __m128i { return _mm_min_epu8(a, b); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto max(__m128i a, __m128i b) -> __m128i { return _mm_max_epu8(a, b); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto count_eq(__m128i a, __m128i b) -> std::size_t { return popcount(static_cast <unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)))); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto count_le(__m128i a, __m128i b) -> std::size_t { return popcount(static_cast <unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(a, b), b)))); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto count_lt(__m128i a, __m128i b) -> std::size_t { return lanes - count_le(b, a); }
+
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_zero() -> __m128i { return _mm_setzero_si128(); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_add(__m128i acc, __m128i v) -> __m128i { return _mm_add_epi64(acc, _mm_sad_epu8(v, _mm_setzero_si128())); }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_dot(__m128i acc, __m128i a, __m128i b) -> __m128i
+        {
+          const auto zero = _mm_setzero_si128();
+          const auto lo = _mm_madd_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+          const auto hi = _mm_madd_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+          const auto products = _mm_add_epi32(lo, hi);
+          return _mm_add_epi64(acc, _mm_add_epi64(_mm_unpacklo_epi32(products, zero), _mm_unpackhi_epi32(products, zero)));
+        }
+        MATSULIB_SIMD_TARGET_SSE2 static inline auto acc_reduce(__m128i acc) -> sum_type
+        {
+          unsigned long long lanes_of_acc[2];
+          _mm_storeu_si128(reinterpret_cast <__m128i *>(lanes_of_acc), acc);
+          return lanes_of_acc[0] + lanes_of_acc[1];
+        }
+      };
+
+      struct Avx2F32
+      {
+      public:
+        using value_type = float;
+        using sum_type = float;
+        using vector = __m256;
+        using accumulator = __m256;
+        static constexpr std::size_t lanes = 8;
+
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto load(const float *data) -> __m256 { return _mm256_loadu_ps(data); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto store(float *data, __m256 v) -> void { _mm256_storeu_ps(data, v); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto set1(float value) -> __m256 { return _mm256_set1_ps(value); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto add(__m256 a, __m256 b) -> __m256 { return _mm256_add_ps(a, b); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto mul(__m256 a, __m256 b) -> __m256 { return _mm256_mul_ps(a, b); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto min(__m256 a, __m256 b) -> __m256 { return _mm256_min_ps(a, b); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto max(__m256 a, __m256 b) -> __m256 { return _mm256_max_ps(a, b); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto count_eq(__m256 a, __m256 b) -> std::size_t { return popcount(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ))); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto count_lt(__m256 a, __m256 b) -> std::size_t { return popcount(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ))); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto count_le(__m256 a, __m256 b) -> std::size_t { return popcount(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ))); }
+
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_zero() -> __m256 { return _mm256_setzero_ps(); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_add(__m256 acc, __m256 v) -> __m256 { return _mm256_add_ps(acc, v); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_dot(__m256 acc, __m256 a, __m256 b) -> __m256 { return _mm256_add_ps(acc, _mm256_mul_ps(a, b)); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_reduce(__m256 acc) -> float
+        {
+          float lanes_of_acc[8];
+          _mm256_storeu_ps(lanes_of_acc, acc);
+          return ((lanes_of_acc[0] + lanes_of_acc[1]) + (lanes_of_acc[2] + lanes_of_acc[3])) + ((lanes_of_acc[4] + lanes_of_acc[5]) + (lanes_of_acc[6] + lanes_of_acc[7]));
+        }
+      };
+
+      struct Avx2I32
+      {
+      public:
+        using value_type = std::int32_t;
+        using sum_type = typename SumType <std::int32_t>::type;
+        using vector = __m256i;
+        using accumulator = __m256i;
+        static constexpr std::size_t lanes = 8;
+
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto load(const std::int32_t *data) -> __m256i { return _mm256_loadu_si256(reinterpret_cast <const __m256i *>(data)); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto store(std::int32_t *data, __m256i v) -> void { _mm256_storeu_si256(reinterpret_cast <__m256i *>(data), v); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto set1(std::int32_t value) -> __m256i { return _mm256_set1_epi32(value); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto add(__m256i a, __m256i b) -> __m256i { return _mm256_add_epi32(a, b); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto mul(__m256i a, __m256i b) -> __m256i { return _mm256_mullo_epi32(a, b); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto min(__m256i a, __m256i b) -> __m256i { return _mm256_min_epi32(a, b); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto max(__m256i a, __m256i b) -> __m256i { return _mm256_max_epi32(a, b); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto count_eq(__m256i a, __m256i b) -> std::size_t { return popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)))); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto count_lt(__m256i a, __m256i b) -> std::size_t { return popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)))); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto count_le(__m256i a, __m256i b) -> std::size_t { return lanes - count_lt(b, a); }
+
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_zero() -> __m256i { return _mm256_setzero_si256(); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_add(__m256i acc, __m256i v) -> __m256i
+        {
+          const auto lo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v));
+          const auto hi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1));
+          return _mm256_add_epi64(acc, _mm256_add_epi64(lo, hi));
+        }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_dot(__m256i acc, __m256i a, __m256i b) -> __m256i
+        {
+          const auto even = _mm256_mul_epi32(a, b);
+          const auto odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+          return _mm256_add_epi64(acc, _mm256_add_epi64(even, odd));
+        }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_reduce(__m256i acc) -> sum_type
+        {
+          long long lanes_of_acc[4];
+          _mm256_storeu_si256(reinterpret_cast <__m256i *>(lanes_of_acc), acc);
+          return (lanes_of_acc[0] + lanes_of_acc[1]) + (lanes_of_acc[2] + lanes_of_acc[3]);
+        }
+      };
+
+      struct Avx2U8
+      {
+      public:
+        using value_type = std::uint8_t;
+        using sum_type = typename SumType <std::uint8_t>::type;
+        using vector = __m256i;
+        using accumulator = __m256i;
+        static constexpr std::size_t lanes = 32;
+
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto load(const std::uint8_t *data) -> __m256i { return _mm256_loadu_si256(reinterpret_cast <const __m256i *>(data)); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto store(std::uint8_t *data, __m256i v) -> void { _mm256_storeu_si256(reinterpret_cast <__m256i *>(data), v); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto set1(std::uint8_t value) -> __m256i { return _mm256_set1_epi8(static_cast <char>(value)); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto add(__m256i a, __m256i b) -> __m256i { return _mm256_add_epi8(a, b); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto mul(__m256i a, __m256i b) -> __m256i
+        {
+          // unpack / pack both work per 128 bit lane, so the byte order is preserved
+          const auto zero = _mm256_setzero_si256();
+          const auto low_byte = _mm256_set1_epi16(0xFF);
+          const auto lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+          const auto hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+          return _mm256_packus_epi16(_mm256_and_si256(lo, low_byte), _mm256_and_si256(hi, low_byte));
+        }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto min(__m256i a, __m256i b) -> __m256i { return _mm256_min_epu8(a, b); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto max(__m256i a, __m256i b) -> __m256i { return _mm256_max_epu8(a, b); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto count_eq(__m256i a, __m256i b) -> std::size_t { return popcount(static_cast <unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)))); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto count_le(__m256i a, __m256i b) -> std::size_t { return popcount(static_cast <unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(a, b), b)))); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto count_lt(__m256i a, __m256i b) -> std::size_t { return lanes - count_le(b, a); }
+
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_zero() -> __m256i { return _mm256_setzero_si256(); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_add(__m256i acc, __m256i v) -> __m256i { return _mm256_add_epi64(acc, _mm256_sad_epu8(v, _mm256_setzero_si256())); }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_dot(__m256i acc, __m256i a, __m256i b) -> __m256i
+        {
+          const auto zero = _mm256_setzero_si256();
+          const auto lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+          const auto hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+          const auto products = _mm256_add_epi32(lo, hi);
+          return _mm256_add_epi64(acc, _mm256_add_epi64(_mm256_unpacklo_epi32(products, zero), _mm256_unpackhi_epi32(products, zero)));
+        }
+        MATSULIB_SIMD_TARGET_AVX2 static inline auto acc_reduce(__m256i acc) -> sum_type
+        {
+          unsigned long long lanes_of_acc[4];
+          _mm256_storeu_si256(reinterpret_cast <__m256i *>(lanes_of_acc), acc);
+          return (lanes_of_acc[0] + lanes_of_acc[1]) + (lanes_of_acc[2] + lanes_of_acc[3]);
+        }
+      };
+
+      namespace sse2
+      {
+#define MATSULIB_SIMD_KERNEL MATSULIB_SIMD_TARGET_SSE2
+#include "details/simd/kernels.hpp"
+#undef MATSULIB_SIMD_KERNEL
+      }
+      namespace avx2
+      {
+#define MATSULIB_SIMD_KERNEL MATSULIB_SIMD_TARGET_AVX2
+#include "details/simd/kernels.hpp"
+#undef MATSULIB_SIMD_KERNEL
+      }
+
+      // Picks the kernel set of the running CPU on every call (isa() is cached).
+      template <class _T, class _Sse2, class _Avx2>
+      struct Dispatch
+      {
+      public:
+        using sum_type = typename SumType <_T>::type;
+
+        static auto sum(const _T *data, std::size_t length) -> sum_type
+        {
+          switch (matsulib::simd::isa())
+          {
+          case Isa::AVX2: return avx2::sum <_Avx2>(data, length);
+          case Isa::SSE2: return sse2::sum <_Sse2>(data, length);
+          default:        return Scalar <_T>::sum(data, length);
+          }
+        }
+        static auto dot(const _T *lhs, const _T *rhs, std::size_t length) -> sum_type
+        {
+          switch (matsulib::simd::isa())
+          {
+          case Isa::AVX2: return avx2::dot <_Avx2>(lhs, rhs, length);
+          case Isa::SSE2: return sse2::dot <_Sse2>(lhs, rhs, length);
+          default:        return Scalar <_T>::dot(lhs, rhs, length);
+          }
+        }
+        static auto min_max(const _T *data, std::size_t length, _T &min_value, _T &max_value) -> void
+        {
+          switch (matsulib::simd::isa())
+          {
+          case Isa::AVX2: return avx2::min_max <_Avx2>(data, length, min_value, max_value);
+          case Isa::SSE2: return sse2::min_max <_Sse2>(data, length, min_value, max_value);
+          default:        return Scalar <_T>::min_max(data, length, min_value, max_value);
+          }
+        }
+        static auto add(_T *dst, const _T *src, std::size_t length) -> void
+        {
+          switch (matsulib::simd::isa())
+          {
+          case Isa::AVX2: return avx2::add <_Avx2>(dst, src, length);
+          case Isa::SSE2: return sse2::add <_Sse2>(dst, src, length);
+          default:        return Scalar <_T>::add(dst, src, length);
+          }
+        }
+        static auto mul(_T *dst, const _T *src, std::size_t length) -> void
+        {
+          switch (matsulib::simd::isa())
+          {
+          case Isa::AVX2: return avx2::mul <_Avx2>(dst, src, length);
+          case Isa::SSE2: return sse2::mul <_Sse2>(dst, src, length);
+          default:        return Scalar <_T>::mul(dst, src, length);
+          }
+        }
+        static auto scale(_T *dst, _T factor, std::size_t length) -> void
+        {
+          switch (matsulib::simd::isa())
+          {
+          case Isa::AVX2: return avx2::scale <_Avx2>(dst, factor, length);
+          case Isa::SSE2: return sse2::scale <_Sse2>(dst, factor, length);
+          default:        return Scalar <_T>::scale(dst, factor, length);
+          }
+        }
+        static auto clamp(_T *dst, _T low, _T high, std::size_t length) -> void
+        {
+          switch (matsulib::simd::isa())
+          {
+          case Isa::AVX2: return avx2::clamp <_Avx2>(dst, low, high, length);
+          case Isa::SSE2: return sse2::clamp <_Sse2>(dst, low, high, length);
+          default:        return Scalar <_T>::clamp(dst, low, high, length);
+          }
+        }
+        static auto count(const _T *data, std::size_t length, Compare compare, _T value) -> std::size_t
+        {
+          switch (matsulib::simd::isa())
+          {
+          case Isa::AVX2: return avx2::count <_Avx2>(data, length, compare, value);
+          case Isa::SSE2: return sse2::count <_Sse2>(data, length, compare, value);
+          default:        return Scalar <_T>::count(data, length, compare, value);
+          }
+        }
+      };
+
+      template <> struct Kernels <float> : public Dispatch <float, Sse2F32, Avx2F32> {};
+      template <> struct Kernels <std::int32_t> : public Dispatch <std::int32_t, Sse2I32, Avx2I32> {};
+      template <> struct Kernels <std::uint8_t> : public Dispatch <std::uint8_t, Sse2U8, Avx2U8> {};
+#endif
+    }
+  }
+}
\ No newline at end of file
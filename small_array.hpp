@@ -0,0 +1,445 @@
+﻿#pragma once
+
+#include <cstddef>
+
+namespace matsulib
+{
+  template <class _T, std::size_t _N> class SmallArray;
+}
+
+#include "array.hpp"
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Sequence keeping up to _N elements in inline storage (no heap allocation) and spilling to the heap beyond that.
+// Offers the generic callable each / transform / select / map / inject API of Array;
+// select and map return SmallArray <_, _N>, so short results stay inline as well.
+template <class _T, std::size_t _N>
+class matsulib::SmallArray
+{
+public:
+  using value_type = _T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = _T &;
+  using const_reference = const _T &;
+  using pointer = _T *;
+  using const_pointer = const _T *;
+  using iterator = _T *;
+  using const_iterator = const _T *;
+
+protected:
+  _T *_data;
+  size_type _size;
+  size_type _capacity;
+  alignas(_T) unsigned char _storage[sizeof(_T) * (_N == 0 ? 1 : _N)];
+
+public:
+  SmallArray() : _data{ inline_data() }, _size{ 0 }, _capacity{ _N } {}
+  explicit SmallArray(size_type count) : SmallArray{}
+  {
+    resize(count);
+  }
+  SmallArray(size_type count, const _T &value) : SmallArray{}
+  {
+    resize(count, value);
+  }
+  SmallArray(std::initializer_list <_T> values) : SmallArray{}
+  {
+    reserve(values.size());
+    for (const auto &value : values)
+    {
+      push_back(value);
+    }
+  }
+  SmallArray(const SmallArray &other) : SmallArray{}
+  {
+    reserve(other._size);
+    for (size_type i = 0; i < other._size; ++i)
+    {
+      push_back(other._data[i]);
+    }
+  }
+  SmallArray(SmallArray &&other) noexcept(std::is_nothrow_move_constructible <_T>::value) : SmallArray{}
+  {
+    steal(std::move(other));
+  }
+  SmallArray &operator =(const SmallArray &other)
+  {
+    if (this != &other)
+    {
+      clear();
+      reserve(other._size);
+      for (size_type i = 0; i < other._size; ++i)
+      {
+        push_back(other._data[i]);
+      }
+    }
+    return *this;
+  }
+  SmallArray &operator =(SmallArray &&other) noexcept(std::is_nothrow_move_constructible <_T>::value)
+  {
+    if (this != &other)
+    {
+      clear();
+      release();
+      steal(std::move(other));
+    }
+    return *this;
+  }
+  ~SmallArray()
+  {
+    clear();
+    release();
+  }
+
+public:
+  auto size() const -> size_type { return _size; }
+  auto capacity() const -> size_type { return _capacity; }
+  auto empty() const -> bool { return _size == 0; }
+  // true while the elements live in the inline storage
+  auto is_inline() const -> bool { return _data == inline_data(); }
+
+  auto data() -> _T * { return _data; }
+  auto data() const -> const _T * { return _data; }
+  auto begin() -> iterator { return _data; }
+  auto begin() const -> const_iterator { return _data; }
+  auto end() -> iterator { return _data + _size; }
+  auto end() const -> const_iterator { return _data + _size; }
+
+  auto operator [](size_type index) -> _T & { return _data[index]; }
+  auto operator [](size_type index) const -> const _T & { return _data[index]; }
+  auto at(size_type index) -> _T & { return const_cast <_T &>(static_cast <const SmallArray &>(*this).at(index)); }
+  auto at(size_type index) const -> const _T &
+  {
+    if (index >= _size)
+    {
+      throw std::out_of_range{ "matsulib::SmallArray::at() : Out Of Range!!" };
+    }
+    return _data[index];
+  }
+  auto front() -> _T & { return _data[0]; }
+  auto front() const -> const _T & { return _data[0]; }
+  auto back() -> _T & { return _data[_size - 1]; }
+  auto back() const -> const _T & { return _data[_size - 1]; }
+
+  auto reserve(size_type capacity) -> void
+  {
+    if (capacity > _capacity)
+    {
+      reallocate(capacity);
+    }
+  }
+  auto clear() -> void
+  {
+    for (size_type i = 0; i < _size; ++i)
+    {
+      _data[i].~_T();
+    }
+    _size = 0;
+  }
+  auto resize(size_type size) -> void
+  {
+    shrink(size);
+    reserve(size);
+    for (; _size < size; ++_size)
+    {
+      ::new (static_cast <void *>(_data + _size)) _T();
+    }
+  }
+  auto resize(size_type size, const _T &value) -> void
+  {
+    shrink(size);
+    reserve(size);
+    for (; _size < size; ++_size)
+    {
+      ::new (static_cast <void *>(_data + _size)) _T(value);
+    }
+  }
+
+  template <class ..._Args>
+  auto emplace_back(_Args &&...args) -> _T &
+  {
+    if (_size == _capacity)
+    {
+      // construct the new element first : args may refer to an element of this array
+      const auto capacity = _capacity == 0 ? 1 : _capacity * 2;
+      auto allocator = std::allocator <_T>{};
+      const auto data = allocator.allocate(capacity);
+      try
+      {
+        ::new (static_cast <void *>(data + _size)) _T(std::forward <_Args>(args)...);
+      }
+      catch (...)
+      {
+        allocator.deallocate(data, capacity);
+        throw;
+      }
+      try
+      {
+        relocate_elements(data, _data, _size, std::integral_constant <bool, IsTriviallyRelocatable <_T>::value>{});
+      }
+      catch (...)
+      {
+        data[_size].~_T();
+        allocator.deallocate(data, capacity);
+        throw;
+      }
+      adopt(data, capacity);
+    }
+    else
+    {
+      ::new (static_cast <void *>(_data + _size)) _T(std::forward <_Args>(args)...);
+    }
+    return _data[_size++];
+  }
+  auto push_back(const _T &value) -> void { emplace_back(value); }
+  auto push_back(_T &&value) -> void { emplace_back(std::move(value)); }
+  auto pop_back() -> void { _data[--_size].~_T(); }
+
+  auto operator ==(const SmallArray &other) const -> bool
+  {
+    if (_size != other._size)
+    {
+      return false;
+    }
+    for (size_type i = 0; i < _size; ++i)
+    {
+      if (!(_data[i] == other._data[i]))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+  auto operator !=(const SmallArray &other) const -> bool { return !(*this == other); }
+
+  auto to_array() const -> Array <_T>
+  {
+    return Array <_T>(begin(), end());
+  }
+
+public:
+  template <class _Func>
+  auto each_with_index(_Func &&func) const -> const SmallArray &
+  {
+    for (size_type i = 0; i < _size; ++i)
+    {
+      func(static_cast <const _T &>(_data[i]), i);
+    }
+    return *this;
+  }
+  template <class _Func>
+  auto each_with_index(_Func &&func) -> SmallArray &
+  {
+    return const_cast <SmallArray &>(static_cast <const SmallArray &>(*this).each_with_index(std::forward <_Func>(func)));
+  }
+  template <class _Func>
+  auto each(_Func &&func) const -> const SmallArray &
+  {
+    return each_with_index([&func](const _T &value, size_type) { func(value); });
+  }
+  template <class _Func>
+  auto each(_Func &&func) -> SmallArray &
+  {
+    return each_with_index([&func](const _T &value, size_type) { func(value); });
+  }
+
+  template <class _Func>
+  auto transform_with_index(_Func &&func) -> SmallArray &
+  {
+    for (size_type i = 0; i < _size; ++i)
+    {
+      _data[i] = func(std::move(_data[i]), i);
+    }
+    return *this;
+  }
+  template <class _Func>
+  auto transform(_Func &&func) -> SmallArray &
+  {
+    return transform_with_index([&func](_T value, size_type) { return func(std::move(value)); });
+  }
+
+  template <class _Func>
+  auto select_with_index(_Func &&func) const -> SmallArray
+  {
+    auto dst_array = SmallArray{};
+    for (size_type i = 0; i < _size; ++i)
+    {
+      if (func(static_cast <const _T &>(_data[i]), i))
+      {
+        dst_array.push_back(_data[i]);
+      }
+    }
+    return dst_array;
+  }
+  template <class _Func>
+  auto select(_Func &&func) const -> SmallArray
+  {
+    return select_with_index([&func](const _T &value, size_type) { return func(value); });
+  }
+
+  template <class _DistType, class _Func>
+  auto map_with_index(_Func &&func) const -> SmallArray <_DistType, _N>
+  {
+    auto dst_array = SmallArray <_DistType, _N>{};
+    dst_array.reserve(_size);
+    for (size_type i = 0; i < _size; ++i)
+    {
+      dst_array.emplace_back(func(static_cast <const _T &>(_data[i]), i));
+    }
+    return dst_array;
+  }
+  template <class _Func>
+  auto map_with_index(_Func &&func) const -> SmallArray
+  {
+    return map_with_index <_T>(std::forward <_Func>(func));
+  }
+  template <class _DistType, class _Func>
+  auto map(_Func &&func) const -> SmallArray <_DistType, _N>
+  {
+    return map_with_index <_DistType>([&func](const _T &value, size_type) { return func(value); });
+  }
+  template <class _Func>
+  auto map(_Func &&func) const -> SmallArray
+  {
+    return map <_T>(std::forward <_Func>(func));
+  }
+
+  template <class _DistType, class _Func>
+  auto inject_with_index(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _DistType
+  {
+    auto accumulation = std::move(initial_value);
+    for (size_type i = 0; i < _size; ++i)
+    {
+      accumulation = func(std::move(accumulation), static_cast <const _T &>(_data[i]), i);
+    }
+    return accumulation;
+  }
+  template <class _Func>
+  auto inject_with_index(_T initial_value, _Func &&func) const -> _T
+  {
+    return inject_with_index <_T>(std::move(initial_value), std::forward <_Func>(func));
+  }
+  template <class _DistType, class _Func>
+  auto inject(typename _detail::array::Identity <_DistType>::type initial_value, _Func &&func) const -> _DistType
+  {
+    return inject_with_index <_DistType>(std::move(initial_value), [&func](_DistType accumulation, const _T &value, size_type) { return func(std::move(accumulation), value); });
+  }
+  template <class _Func>
+  auto inject(_T initial_value, _Func &&func) const -> _T
+  {
+    return inject <_T>(std::move(initial_value), std::forward <_Func>(func));
+  }
+  template <class _DistType, class _Func>
+  auto inject(_Func &&func) const -> _DistType
+  {
+    return inject <_DistType>(_DistType{}, std::forward <_Func>(func));
+  }
+  template <class _Func>
+  auto inject(_Func &&func) const -> _T
+  {
+    return inject <_T>(_T{}, std::forward <_Func>(func));
+  }
+
+protected:
+  auto inline_data() -> _T * { return reinterpret_cast <_T *>(_storage); }
+  auto inline_data() const -> const _T * { return reinterpret_cast <const _T *>(_storage); }
+
+  auto shrink(size_type size) -> void
+  {
+    while (_size > size)
+    {
+      pop_back();
+    }
+  }
+  // frees the old heap block and switches to data (capacity elements) once the elements have been relocated into it
+  auto adopt(_T *data, size_type capacity) -> void
+  {
+    release();
+    _data = data;
+    _capacity = capacity;
+  }
+  // on an exception the new block is freed and the array is unchanged
+  auto reallocate(size_type capacity) -> void
+  {
+    auto allocator = std::allocator <_T>{};
+    const auto data = allocator.allocate(capacity);
+    try
+    {
+      relocate_elements(data, _data, _size, std::integral_constant <bool, IsTriviallyRelocatable <_T>::value>{});
+    }
+    catch (...)
+    {
+      allocator.deallocate(data, capacity);
+      throw;
+    }
+    adopt(data, capacity);
+  }
+  // constructs dst [0, size) from src [0, size) and ends the lifetime of the sources.
+  // If a constructor throws, the elements constructed in dst are destroyed and src is left as it was.
+  static auto relocate_elements(_T *dst, _T *src, size_type size, std::true_type) -> void
+  {
+    if (size != 0)
+    {
+      std::memcpy(static_cast <void *>(dst), static_cast <const void *>(src), sizeof(_T) * size);
+    }
+  }
+  static auto relocate_elements(_T *dst, _T *src, size_type size, std::false_type) -> void
+  {
+    size_type constructed = 0;
+    try
+    {
+      for (; constructed < size; ++constructed)
+      {
+        ::new (static_cast <void *>(dst + constructed)) _T(std::move_if_noexcept(src[constructed]));
+      }
+    }
+    catch (...)
+    {
+      while (constructed != 0)
+      {
+        dst[--constructed].~_T();
+      }
+      throw;
+    }
+    for (size_type i = 0; i < size; ++i)
+    {
+      src[i].~_T();
+    }
+  }
+  // frees the heap block (elements must already be destroyed or moved out)
+  auto release() -> void
+  {
+    if (!is_inline())
+    {
+      std::allocator <_T>{}.deallocate(_data, _capacity);
+      _data = inline_data();
+      _capacity = _N;
+    }
+  }
+  // takes other's heap block, or moves its inline elements one by one
+  auto steal(SmallArray &&other) -> void
+  {
+    if (other.is_inline())
+    {
+      relocate_elements(_data, other._data, other._size, std::integral_constant <bool, IsTriviallyRelocatable <_T>::value>{});
+      _size = other._size;
+      other._size = 0;
+    }
+    else
+    {
+      _data = other._data;
+      _size = other._size;
+      _capacity = other._capacity;
+      other._data = other.inline_data();
+      other._size = 0;
+      other._capacity = _N;
+    }
+  }
+};
\ No newline at end of file
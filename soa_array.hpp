@@ -0,0 +1,250 @@
+﻿#pragma once
+
+#include <cstddef>
+
+namespace matsulib
+{
+  template <class ..._Fields> class SoaArray;
+  template <class _Soa, std::size_t ..._Indices> class SoaFields;
+}
+
+#include "array.hpp"
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace matsulib
+{
+  namespace _detail
+  {
+    namespace soa_array
+    {
+      using Swallow = int[];
+
+      // func(column_0[i], column_1[i], ..., i) over raw column pointers, so the loop can be vectorized.
+      template <class _Func, class ..._Pointers>
+      inline auto loop(std::size_t length, _Func &func, _Pointers ...columns) -> void
+      {
+        for (std::size_t i = 0; i < length; ++i)
+        {
+          func(columns[i]..., i);
+        }
+      }
+    }
+  }
+}
+
+// Subset of SoaArray columns (chosen by _Indices) visited together.
+// Only the chosen columns are read, so the other fields never pass through the cache.
+// Callables receive one reference per chosen field (const when _Soa is const).
+template <class _Soa, std::size_t ..._Indices>
+class matsulib::SoaFields
+{
+public:
+  using size_type = std::size_t;
+  using soa_type = typename std::remove_const <_Soa>::type;
+  // decayed result of func(field_values...)
+  template <class _Func>
+  using result_type = typename std::decay <decltype(std::declval <_Func &>()(std::declval <typename std::tuple_element <_Indices, typename soa_type::tuple_type>::type &>()...))>::type;
+
+protected:
+  _Soa *_soa;
+
+public:
+  explicit SoaFields(_Soa &soa) : _soa{ &soa } {}
+
+public:
+  template <class _Func>
+  auto each_with_index(_Func &&func) const -> void
+  {
+    _detail::soa_array::loop(_soa->size(), func, _soa->template column <_Indices>().data()...);
+  }
+  template <class _Func>
+  auto each(_Func &&func) const -> void
+  {
+    each_with_index([&func](auto &...values) { call_without_index(func, values...); });
+  }
+
+  template <class _Func>
+  auto select_with_index(_Func &&func) const -> soa_type
+  {
+    auto selected = std::vector <unsigned char>(_soa->size());
+    size_type count = 0;
+    each_with_index([&](const auto &...values)
+    {
+      const auto index = last(values...);
+      selected[index] = func(values...) ? 1 : 0;
+      count += selected[index];
+    });
+    return _soa->compact(selected, count);
+  }
+  template <class _Func>
+  auto select(_Func &&func) const -> soa_type
+  {
+    return select_with_index([&func](const auto &...values) { return call_without_index(func, values...); });
+  }
+
+  template <class _DistType, class _Func>
+  auto map_with_index(_Func &&func) const -> Array <_DistType>
+  {
+    auto dst_array = Array <_DistType>{};
+    dst_array.reserve(_soa->size());
+    each_with_index([&](auto &...values)
+    {
+      dst_array.emplace_back(func(values...));
+    });
+    return dst_array;
+  }
+  template <class _DistType, class _Func>
+  auto map(_Func &&func) const -> Array <_DistType>
+  {
+    return map_with_index <_DistType>([&func](auto &...values) { return call_without_index(func, values...); });
+  }
+  template <class _Func>
+  auto map(_Func &&func) const -> Array <result_type <_Func>>
+  {
+    return map <result_type <_Func>>(std::forward <_Func>(func));
+  }
+
+  // func(accumulation, field_values...) -> accumulation
+  template <class _DistType, class _Func>
+  auto inject(_DistType initial_value, _Func &&func) const -> _DistType
+  {
+    auto accumulation = std::move(initial_value);
+    each_with_index([&](auto &...values)
+    {
+      accumulation = call_without_index([&](auto &...fields) { return func(std::move(accumulation), fields...); }, values...);
+    });
+    return accumulation;
+  }
+
+protected:
+  // the trailing index argument
+  template <class ..._Args>
+  static auto last(const _Args &...args) -> size_type { return std::get <sizeof...(_Args) - 1>(std::forward_as_tuple(args...)); }
+
+  // drops the trailing index argument
+  template <class _Func, class ..._Args>
+  static auto call_without_index(_Func &&func, _Args &...args) -> decltype(auto)
+  {
+    return call_prefix(func, std::forward_as_tuple(args...), std::make_index_sequence <sizeof...(_Args) - 1>{});
+  }
+  template <class _Func, class _Tuple, std::size_t ..._Positions>
+  static auto call_prefix(_Func &func, _Tuple &&args, std::index_sequence <_Positions...>) -> decltype(auto)
+  {
+    return func(std::get <_Positions>(args)...);
+  }
+};
+
+// Struct-of-arrays container : field k of every row is stored contiguously in column <k>() (an Array).
+// fields <k...>() visits a subset of the columns, and each / select / map / inject over all fields are provided as shortcuts.
+template <class ..._Fields>
+class matsulib::SoaArray
+{
+  template <class, std::size_t ...> friend class matsulib::SoaFields;
+
+public:
+  using size_type = std::size_t;
+  using tuple_type = std::tuple <_Fields...>;
+  static constexpr std::size_t num_of_fields = sizeof...(_Fields);
+
+protected:
+  std::tuple <Array <_Fields>...> _columns;
+
+public:
+  SoaArray() = default;
+  SoaArray(const SoaArray &) = default;
+  SoaArray(SoaArray &&) = default;
+  SoaArray &operator =(const SoaArray &) = default;
+  SoaArray &operator =(SoaArray &&) = default;
+
+public:
+  template <std::size_t _Index>
+  auto column() -> Array <typename std::tuple_element <_Index, tuple_type>::type> & { return std::get <_Index>(_columns); }
+  template <std::size_t _Index>
+  auto column() const -> const Array <typename std::tuple_element <_Index, tuple_type>::type> & { return std::get <_Index>(_columns); }
+
+  template <std::size_t ..._Indices>
+  auto fields() -> SoaFields <SoaArray, _Indices...> { return SoaFields <SoaArray, _Indices...>{ *this }; }
+  template <std::size_t ..._Indices>
+  auto fields() const -> SoaFields <const SoaArray, _Indices...> { return SoaFields <const SoaArray, _Indices...>{ *this }; }
+
+  auto size() const -> size_type { return std::get <0>(_columns).size(); }
+  auto empty() const -> bool { return size() == 0; }
+
+  auto reserve(size_type capacity) -> void { for_each_column([capacity](auto &column) { column.reserve(capacity); }); }
+  auto resize(size_type size) -> void { for_each_column([size](auto &column) { column.resize(size); }); }
+  auto clear() -> void { for_each_column([](auto &column) { column.clear(); }); }
+
+  auto push_back(const _Fields &...values) -> void
+  {
+    push_back_impl(std::index_sequence_for <_Fields...>{}, values...);
+  }
+  // a row as a tuple of references to its fields
+  auto operator [](size_type index) -> std::tuple <_Fields &...> { return row(index, std::index_sequence_for <_Fields...>{}); }
+  auto operator [](size_type index) const -> std::tuple <const _Fields &...> { return row(index, std::index_sequence_for <_Fields...>{}); }
+
+  template <class _Func>
+  auto each_with_index(_Func &&func) -> SoaArray & { all_fields(std::index_sequence_for <_Fields...>{}).each_with_index(std::forward <_Func>(func)); return *this; }
+  template <class _Func>
+  auto each_with_index(_Func &&func) const -> const SoaArray & { all_fields(std::index_sequence_for <_Fields...>{}).each_with_index(std::forward <_Func>(func)); return *this; }
+  template <class _Func>
+  auto each(_Func &&func) -> SoaArray & { all_fields(std::index_sequence_for <_Fields...>{}).each(std::forward <_Func>(func)); return *this; }
+  template <class _Func>
+  auto each(_Func &&func) const -> const SoaArray & { all_fields(std::index_sequence_for <_Fields...>{}).each(std::forward <_Func>(func)); return *this; }
+  template <class _Func>
+  auto select(_Func &&func) const -> SoaArray { return all_fields(std::index_sequence_for <_Fields...>{}).select(std::forward <_Func>(func)); }
+  template <class _DistType, class _Func>
+  auto map(_Func &&func) const -> Array <_DistType> { return all_fields(std::index_sequence_for <_Fields...>{}).template map <_DistType>(std::forward <_Func>(func)); }
+  template <class _DistType, class _Func>
+  auto inject(_DistType initial_value, _Func &&func) const -> _DistType { return all_fields(std::index_sequence_for <_Fields...>{}).inject(std::move(initial_value), std::forward <_Func>(func)); }
+
+protected:
+  template <class _Func>
+  auto for_each_column(_Func &&func) -> void { for_each_column_impl(func, std::index_sequence_for <_Fields...>{}); }
+  template <class _Func, std::size_t ..._Indices>
+  auto for_each_column_impl(_Func &func, std::index_sequence <_Indices...>) -> void
+  {
+    (void)_detail::soa_array::Swallow{ 0, (func(std::get <_Indices>(_columns)), 0)... };
+  }
+  template <std::size_t ..._Indices>
+  auto push_back_impl(std::index_sequence <_Indices...>, const _Fields &...values) -> void
+  {
+    (void)_detail::soa_array::Swallow{ 0, (std::get <_Indices>(_columns).push_back(values), 0)... };
+  }
+  template <std::size_t ..._Indices>
+  auto row(size_type index, std::index_sequence <_Indices...>) -> std::tuple <_Fields &...> { return std::tuple <_Fields &...>{ std::get <_Indices>(_columns)[index]... }; }
+  template <std::size_t ..._Indices>
+  auto row(size_type index, std::index_sequence <_Indices...>) const -> std::tuple <const _Fields &...> { return std::tuple <const _Fields &...>{ std::get <_Indices>(_columns)[index]... }; }
+  template <std::size_t ..._Indices>
+  auto all_fields(std::index_sequence <_Indices...>) -> SoaFields <SoaArray, _Indices...> { return fields <_Indices...>(); }
+  template <std::size_t ..._Indices>
+  auto all_fields(std::index_sequence <_Indices...>) const -> SoaFields <const SoaArray, _Indices...> { return fields <_Indices...>(); }
+
+  // copy of the rows whose selected flag is set (count of them)
+  auto compact(const std::vector <unsigned char> &selected, size_type count) const -> SoaArray
+  {
+    auto dst = SoaArray{};
+    dst.reserve(count);
+    dst.for_each_column_pair(*this, selected, std::index_sequence_for <_Fields...>{});
+    return dst;
+  }
+  template <std::size_t ..._Indices>
+  auto for_each_column_pair(const SoaArray &src, const std::vector <unsigned char> &selected, std::index_sequence <_Indices...>) -> void
+  {
+    (void)_detail::soa_array::Swallow{ 0, (append_selected(std::get <_Indices>(_columns), std::get <_Indices>(src._columns), selected), 0)... };
+  }
+  template <class _Column>
+  static auto append_selected(_Column &dst, const _Column &src, const std::vector <unsigned char> &selected) -> void
+  {
+    const auto length = src.size();
+    for (size_type i = 0; i < length; ++i)
+    {
+      if (selected[i])
+      {
+        dst.push_back(src[i]);
+      }
+    }
+  }
+};
\ No newline at end of file